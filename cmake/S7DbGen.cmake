@@ -0,0 +1,33 @@
+# Generate C++ layouts of S7 data blocks from TIA Portal sources with s7dbgen.
+#
+#   s7dbgen_layout(<target> HEADER <header.h> SOURCES <file.db|file.udt>... [NAMESPACE <ns>])
+#
+# The header is written to the binary directory and added to the include path of <target>.
+# It is regenerated whenever one of the sources (or s7dbgen itself) changes.
+function(s7dbgen_layout target)
+  cmake_parse_arguments(ARG "" "HEADER;NAMESPACE" "SOURCES" ${ARGN})
+  if(NOT ARG_HEADER OR NOT ARG_SOURCES)
+    message(FATAL_ERROR "s7dbgen_layout: HEADER and SOURCES are required")
+  endif()
+  if(NOT ARG_NAMESPACE)
+    set(ARG_NAMESPACE s7db)
+  endif()
+
+  set(dir ${CMAKE_CURRENT_BINARY_DIR}/s7dbgen)
+  set(header ${dir}/${ARG_HEADER})
+  set(sources)
+  foreach(source ${ARG_SOURCES})
+    get_filename_component(source ${source} ABSOLUTE)
+    list(APPEND sources ${source})
+  endforeach()
+
+  add_custom_command(
+    OUTPUT ${header}
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${dir}
+    COMMAND s7dbgen -n ${ARG_NAMESPACE} -o ${header} ${sources}
+    DEPENDS s7dbgen ${sources}
+    COMMENT "Generating S7 DB layout ${ARG_HEADER}"
+    VERBATIM)
+  target_sources(${target} PRIVATE ${header})
+  target_include_directories(${target} PRIVATE ${dir})
+endfunction()
@@ -0,0 +1,122 @@
+/*
+ * bench_eventlog.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ *
+ * Records per second and latency of recording into the event log, and the rate a segment is
+ * scanned with. The log is left in the directory for timing plcwatchd-log on it.
+ *
+ *   bench_eventlog [-t threads] [-n records per thread] [-d directory]
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "eventlog.h"
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+int main(int argc, char *argv[]) {
+   int threads = 4;
+   int records = 1000000;
+   string dir = "/tmp/bench_eventlog";
+   int option;
+   while ((option = getopt(argc, argv, "t:n:d:")) != -1) {
+      switch (option) {
+      case 't':
+         threads = max(1, atoi(optarg));
+         break;
+      case 'n':
+         records = max(1, atoi(optarg));
+         break;
+      case 'd':
+         dir = optarg;
+         break;
+      default:
+         cerr << "Usage: bench_eventlog [-t threads] [-n records per thread] [-d directory]" << endl;
+         return EXIT_FAILURE;
+      }
+   }
+   for (const string& segment : event_segments(dir)) {
+      unlink(segment.c_str());
+   }
+
+   vector<vector<uint32_t>> latencies(threads, vector<uint32_t>(records));
+   Clock::duration elapsed;
+   {
+      EventLog log;
+      if (!log.open(dir, 64 << 20, 64)) {
+         return EXIT_FAILURE;
+      }
+      vector<uint16_t> ids;
+      for (int t = 0; t < threads; ++t) {
+         ids.push_back(log.plc("plc" + to_string(t)));
+      }
+      vector<thread> producers;
+      Clock::time_point start = Clock::now();
+      for (int t = 0; t < threads; ++t) {
+         producers.emplace_back([&, t] {
+            static const string title = "Homeautomation system crashed";
+            static const string receipt = "oqfhww0en8ar0whc8vqrz1evdd3t9y";
+            for (int i = 0; i < records; ++i) {
+               Clock::time_point begin = Clock::now();
+               switch (i & 3) {
+               case 0:
+                  log.connect(ids[t], 0, 1200);
+                  break;
+               case 1:
+                  log.status(ids[t], i & 4 ? 8 : 4, 8, 0x4302);
+                  break;
+               case 2:
+                  log.push(ids[t], 2, title);
+                  break;
+               default:
+                  log.receipt(ids[t], ReceiptIssued, receipt, 200);
+               }
+               latencies[t][i] = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - begin).count();
+            }
+         });
+      }
+      for (thread& p : producers) {
+         p.join();
+      }
+      elapsed = Clock::now() - start;
+   }
+
+   vector<uint32_t> all;
+   for (const auto& l : latencies) {
+      all.insert(all.end(), l.begin(), l.end());
+   }
+   sort(all.begin(), all.end());
+   double total = (double) threads * records;
+   cout << threads << " threads: " << (long) (total / chrono::duration<double>(elapsed).count())
+         << " records/s, latency p50 " << all[all.size() / 2] << " ns, p99 " << all[all.size() * 99 / 100]
+         << " ns, max " << all.back() << " ns" << endl;
+
+   size_t bytes = 0;
+   size_t count = 0;
+   Clock::time_point start = Clock::now();
+   for (const string& segment : event_segments(dir)) {
+      EventReader reader;
+      string error;
+      if (!reader.open(segment, error)) {
+         cerr << segment << ": " << error << endl;
+         return EXIT_FAILURE;
+      }
+      while (const EventRecord* r = reader.next()) {
+         bytes += r->size;
+         ++count;
+      }
+   }
+   double seconds = chrono::duration<double>(Clock::now() - start).count();
+   cout << "scan: " << count << " records, " << (long) (bytes / seconds / 1e6) << " MB/s" << endl;
+   cout << "decode: time plcwatchd-log " << dir << " > /dev/null" << endl;
+   return EXIT_SUCCESS;
+}
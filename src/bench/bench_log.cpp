@@ -0,0 +1,103 @@
+/*
+ * bench_log.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ *
+ * Log records per second and producer latency of the former synchronous tcout() (localtime() and
+ * a formatted time stamp per line, written through std::cout) and the asynchronous logger.
+ *
+ *   bench_log [-t threads] [-n records per thread] [-o file]
+ *
+ * The log goes to /dev/null by default, pass a file to include the disk.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "log.hpp"
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+/** @brief tcout() before the asynchronous logger */
+static std::ostream& legacy_tcout() {
+   time_t t = time(0);
+   struct tm *now = localtime(&t);
+   std::cout << 1900 + now->tm_year << "-" << 1 + now->tm_mon << "-" << now->tm_mday << " " << now->tm_hour << ":"
+         << now->tm_min << ":" << now->tm_sec << ": ";
+   return std::cout;
+}
+
+static void run(const char* name, int threads, int records, const function<ostream&()>& log) {
+   vector<vector<uint32_t>> latencies(threads, vector<uint32_t>(records));
+   vector<thread> producers;
+   Clock::time_point start = Clock::now();
+   for (int t = 0; t < threads; ++t) {
+      producers.emplace_back([&, t] {
+         for (int i = 0; i < records; ++i) {
+            Clock::time_point begin = Clock::now();
+            log() << "plc" << t << ": DB10.DBD4 = " << i * 0.5 << ", state " << (i & 7) << endl;
+            latencies[t][i] = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - begin).count();
+         }
+      });
+   }
+   for (thread& p : producers) {
+      p.join();
+   }
+   Clock::duration produced = Clock::now() - start;
+   logging::Logger::instance().stop();
+   Clock::duration written = Clock::now() - start;
+
+   vector<uint32_t> all;
+   for (const auto& l : latencies) {
+      all.insert(all.end(), l.begin(), l.end());
+   }
+   sort(all.begin(), all.end());
+   double total = (double) threads * records;
+   cerr << name << ": " << (long) (total / chrono::duration<double>(produced).count()) << " records/s produced, "
+         << (long) (total / chrono::duration<double>(written).count()) << " records/s written, latency p50 "
+         << all[all.size() / 2] << " ns, p99 " << all[all.size() * 99 / 100] << " ns, max " << all.back() << " ns"
+         << endl;
+}
+
+int main(int argc, char *argv[]) {
+   int threads = 4;
+   int records = 200000;
+   const char* file = "/dev/null";
+   int option;
+   while ((option = getopt(argc, argv, "t:n:o:")) != -1) {
+      switch (option) {
+      case 't':
+         threads = max(1, atoi(optarg));
+         break;
+      case 'n':
+         records = max(1, atoi(optarg));
+         break;
+      case 'o':
+         file = optarg;
+         break;
+      default:
+         cerr << "Usage: bench_log [-t threads] [-n records per thread] [-o file]" << endl;
+         return EXIT_FAILURE;
+      }
+   }
+   if (!freopen(file, "a", stdout)) {
+      cerr << file << ": unable to open" << endl;
+      return EXIT_FAILURE;
+   }
+   cerr << threads << " threads, " << records << " records each, log " << file << endl;
+
+   run("legacy tcout()", threads, records, legacy_tcout);
+   logging::Logger::instance().start();
+   run("async tcout() ", threads, records, tcout);
+   return EXIT_SUCCESS;
+}
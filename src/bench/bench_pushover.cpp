@@ -0,0 +1,166 @@
+/*
+ * bench_pushover.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ *
+ * Notification throughput and STOP-to-acknowledge latency against pushover-mock.
+ *
+ *   pushover-mock -p 8081 -a 500 &
+ *   bench_pushover [-A http://localhost:8081/1] [-n messages] [-e emergencies] [-L port] [-P]
+ *
+ * The latency includes the acknowledge delay (-a) of the mock. Without -P the acknowledgement
+ * arrives on the callback receiver, with -P it is found by polling the receipt every 5 seconds.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "callback.h"
+#include "pushover.h"
+#include "receipts.h"
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+/** @brief Counts down completions */
+class Latch {
+public:
+   explicit Latch(int count) :
+         count(count) {
+   }
+   void done() {
+      lock_guard<std::mutex> lock(mutex);
+      if (--count == 0) {
+         zero.notify_all();
+      }
+   }
+   bool wait(chrono::seconds timeout) {
+      unique_lock<std::mutex> lock(mutex);
+      return zero.wait_for(lock, timeout, [this] {return count <= 0;});
+   }
+private:
+   std::mutex mutex;
+   condition_variable zero;
+   int count;
+};
+
+static double ms(Clock::duration d) {
+   return chrono::duration<double, milli>(d).count();
+}
+
+int main(int argc, char *argv[]) {
+   string api = "http://localhost:8081/1";
+   int messages = 1000;
+   int emergencies = 20;
+   string port = "18090";
+   bool polling = false;
+   int option;
+   while ((option = getopt(argc, argv, "A:n:e:L:P")) != -1) {
+      switch (option) {
+      case 'A':
+         api = optarg;
+         break;
+      case 'n':
+         messages = atoi(optarg);
+         break;
+      case 'e':
+         emergencies = atoi(optarg);
+         break;
+      case 'L':
+         port = optarg;
+         break;
+      case 'P':
+         polling = true;
+         break;
+      default:
+         cerr << "Usage: bench_pushover [-A api] [-n messages] [-e emergencies] [-L port] [-P]" << endl;
+         return EXIT_FAILURE;
+      }
+   }
+
+   // the client logs every request, keep the results readable
+   cout.setstate(ios::failbit);
+   curl_global_init(CURL_GLOBAL_ALL);
+   {
+      Pushover pushover(api);
+      ReceiptTracker receipts(pushover);
+      CallbackServer callbacks(receipts);
+      if (!polling && !callbacks.listen("127.0.0.1:" + port)) {
+         return EXIT_FAILURE;
+      }
+
+      // notifications per second
+      atomic<int> failed { 0 };
+      Latch sent(messages);
+      Clock::time_point start = Clock::now();
+      for (int i = 0; i < messages; ++i) {
+         pushover.push_emergency("bench", "message", "0", "60", "600", "key", "token", NULL, NULL,
+               [&](const PushoverResult& r) {
+                  if (r.status != 1) {
+                     ++failed;
+                  }
+                  sent.done();
+               });
+      }
+      bool complete = sent.wait(chrono::seconds(120));
+      Clock::duration elapsed = Clock::now() - start;
+
+      // STOP to acknowledge
+      string callback = polling ? string() : "http://127.0.0.1:" + port + "/";
+      vector<Clock::duration> latencies(emergencies);
+      atomic<int> lost { 0 };
+      Latch acknowledged(emergencies);
+      for (int i = 0; i < emergencies; ++i) {
+         Clock::time_point stop = Clock::now();
+         pushover.push_emergency("bench", "stop", "2", "60", "600", "key", "token", NULL,
+               callback.empty() ? NULL : callback.c_str(), [&, i, stop](const PushoverResult& r) {
+                  if (r.receipt.empty()) {
+                     ++lost;
+                     acknowledged.done();
+                     return;
+                  }
+                  receipts.track(r.receipt, "token", polling ? chrono::seconds(5) : chrono::seconds(60),
+                        chrono::seconds(600), [&, i, stop](const PushoverResult& e) {
+                           if (e.acknowledged) {
+                              latencies[i] = Clock::now() - stop;
+                           } else {
+                              ++lost;
+                           }
+                           acknowledged.done();
+                        });
+               });
+      }
+      bool acked = acknowledged.wait(chrono::seconds(120));
+
+      cout.clear();
+      cout << "api " << api << endl;
+      cout << messages << " notifications in " << ms(elapsed) << " ms: " << messages / (ms(elapsed) / 1000)
+            << " per second, " << failed << " failed" << (complete ? "" : ", timed out") << endl;
+      sort(latencies.begin(), latencies.end());
+      vector<Clock::duration> valid;
+      for (Clock::duration d : latencies) {
+         if (d.count()) {
+            valid.push_back(d);
+         }
+      }
+      cout << emergencies << " emergencies acknowledged via " << (polling ? "receipt polling" : "callback");
+      if (!valid.empty()) {
+         cout << ": min " << ms(valid.front()) << " ms, median " << ms(valid[valid.size() / 2]) << " ms, max "
+               << ms(valid.back()) << " ms";
+      }
+      cout << ", " << lost << " lost" << (acked ? "" : ", timed out") << endl;
+      Pushover::Budget budget = pushover.budget();
+      cout << "quota " << budget.remaining << " of " << budget.limit << " left, " << budget.dropped << " dropped" << endl;
+      cout.setstate(ios::failbit);
+   }
+   curl_global_cleanup();
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/*
+ * bench_response.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ *
+ * Parsing of pushover.net responses: the former rapidjson DOM path against the in-situ SAX
+ * handler used by the client, time and heap allocations per response.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include "response.h"
+
+#include "rapidjson/document.h"
+
+using namespace std;
+
+static atomic<unsigned long> allocations { 0 };
+
+void* operator new(size_t size) {
+   ++allocations;
+   if (void* p = malloc(size ? size : 1)) {
+      return p;
+   }
+   throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+   free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+   free(p);
+}
+
+static const char* const responses[] = {
+   "{\"status\":1,\"request\":\"647d2300-702c-4b38-8b2f-d56326ae460b\",\"receipt\":\"rLqVuqTRh62UzxtmqiaLzQmVcPgiCy\"}",
+   "{\"status\":1,\"acknowledged\":1,\"acknowledged_at\":1360019238,\"acknowledged_by\":\"uQiRzpo4DXghDmr9QzzfQu27cmVRsG\","
+         "\"acknowledged_by_device\":\"iphone\",\"last_delivered_at\":1360001238,\"expired\":0,\"expires_at\":1360019290,"
+         "\"called_back\":0,\"called_back_at\":0,\"request\":\"6bfc34e6-c8ca-4a4c-b4ff-6ba3b3c9c2c6\"}",
+   "{\"user\":\"invalid\",\"errors\":[\"user identifier is invalid\"],\"status\":0,"
+         "\"request\":\"5042853c-402d-4a18-abcb-168734a801de\"}",
+};
+
+/** @brief Former path: copy of the body into a DOM, then the member lookups */
+static int dom(const string& body) {
+   rapidjson::Document document;
+   document.Parse(body.c_str());
+   int n = 0;
+   if (!document.HasParseError()) {
+      if (document.HasMember("status")) {
+         n += document["status"].GetInt();
+      }
+      if (document.HasMember("receipt")) {
+         n += strlen(document["receipt"].GetString());
+      }
+      if (document.HasMember("acknowledged")) {
+         n += document["acknowledged"].GetInt();
+      }
+      if (document.HasMember("expired")) {
+         n += document["expired"].GetInt();
+      }
+   }
+   return n;
+}
+
+/** @brief Current path: in-situ SAX on the reused receive buffer */
+static int sax(string& buffer, const string& body) {
+   buffer.assign(body); // what curl_process does, the buffer keeps its capacity
+   PushoverResponse response;
+   int n = 0;
+   if (parse_response(&buffer[0], response)) {
+      n = response.status + strlen(response.receipt) + response.acknowledged + response.expired;
+   }
+   return n;
+}
+
+int main(int argc, char *argv[]) {
+   long rounds = argc > 1 ? atol(argv[1]) : 1000000;
+   string bodies[3] = { responses[0], responses[1], responses[2] };
+   string buffer;
+   buffer.reserve(4096);
+   volatile int sink = 0;
+
+   cout << setw(28) << "path" << setw(14) << "ns/response" << setw(16) << "allocs/response" << endl;
+   for (int path = 0; path < 2; ++path) {
+      unsigned long before = allocations;
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      for (long i = 0; i < rounds; ++i) {
+         const string& body = bodies[i % 3];
+         sink = sink + (path == 0 ? dom(body) : sax(buffer, body));
+      }
+      chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+      cout << setw(28) << (path == 0 ? "rapidjson DOM" : "in-situ SAX") << setw(14) << fixed << setprecision(1)
+            << elapsed.count() / rounds << setw(16) << setprecision(2)
+            << (double) (allocations - before) / rounds << endl;
+   }
+   return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * bench_s7decode.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ *
+ * Throughput of the bulk big endian conversion, per implementation and element size.
+ * Usage: bench_s7decode [bytes]   default 65536, the largest DB image worth reading at once
+ */
+
+#include <stdlib.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "s7decode.h"
+
+using namespace std;
+
+typedef void (*SwapFn)(const void*, void*, size_t);
+
+static volatile uint8_t sink;
+
+/** @return throughput in GB/s */
+static double measure(SwapFn swap, int width, const vector<uint8_t>& src, vector<uint8_t>& dst) {
+   size_t count = src.size() / width;
+   size_t rounds = max<size_t>(1, (size_t) 4000000000 / src.size());
+   swap(src.data(), dst.data(), count); // warm up
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (size_t i = 0; i < rounds; ++i) {
+      swap(src.data(), dst.data(), count);
+      sink = dst[i % dst.size()];
+   }
+   chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+   return (double) rounds * count * width / elapsed.count() / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+   size_t bytes = argc > 1 ? strtoul(argv[1], NULL, 0) : 65536;
+   vector<uint8_t> src(bytes), dst(bytes);
+   for (size_t i = 0; i < bytes; ++i) {
+      src[i] = (uint8_t) (i * 131 + 7);
+   }
+
+   cout << "bulk decode of " << bytes << " bytes, GB/s" << endl;
+   cout << setw(8) << "isa" << setw(10) << "16 bit" << setw(10) << "32 bit" << setw(10) << "64 bit" << endl;
+   for (s7::Isa isa : { s7::Isa::Scalar, s7::Isa::SSE2, s7::Isa::AVX2 }) {
+      if (!s7::set_decode_isa(isa)) {
+         cout << setw(8) << s7::isa_name(isa) << "  not supported" << endl;
+         continue;
+      }
+      cout << setw(8) << s7::isa_name(isa) << fixed << setprecision(2)
+            << setw(10) << measure(s7::swap16, 2, src, dst)
+            << setw(10) << measure(s7::swap32, 4, src, dst)
+            << setw(10) << measure(s7::swap64, 8, src, dst) << endl;
+   }
+   return 0;
+}
@@ -0,0 +1,250 @@
+/*
+ * eventlog.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include "eventlog.h"
+#include "log.hpp"
+
+using namespace std;
+
+static const char magic[8] = { 'P', 'L', 'C', 'E', 'V', 'L', 'O', 'G' };
+static const char prefix[] = "events.";
+
+static uint64_t clock_ns(clockid_t id) {
+   struct timespec ts;
+   clock_gettime(id, &ts);
+   return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/** @brief Sequence of a segment file name, 0 for other files */
+static uint64_t segment_sequence(const char* name) {
+   if (strncmp(name, prefix, sizeof(prefix) - 1)) {
+      return 0;
+   }
+   char* end;
+   uint64_t sequence = strtoull(name + sizeof(prefix) - 1, &end, 10);
+   return *end ? 0 : sequence;
+}
+
+vector<string> event_segments(const string& directory) {
+   vector<pair<uint64_t, string>> found;
+   DIR* d = opendir(directory.c_str());
+   if (!d) {
+      return vector<string>();
+   }
+   while (struct dirent* entry = readdir(d)) {
+      if (uint64_t sequence = segment_sequence(entry->d_name)) {
+         found.emplace_back(sequence, directory + "/" + entry->d_name);
+      }
+   }
+   closedir(d);
+   sort(found.begin(), found.end());
+   vector<string> paths;
+   for (auto& f : found) {
+      paths.push_back(move(f.second));
+   }
+   return paths;
+}
+
+uint64_t EventLog::now() {
+   return clock_ns(CLOCK_MONOTONIC);
+}
+
+EventLog::EventLog() {
+}
+
+EventLog::~EventLog() {
+   lock_guard<std::mutex> lock(mutex);
+   close();
+}
+
+bool EventLog::open(const string& directory, size_t size, unsigned segments) {
+   lock_guard<std::mutex> lock(mutex);
+   if (mkdir(directory.c_str(), 0755) < 0 && errno != EEXIST) {
+      tcerr() << "Event log: unable to create " << directory << ": " << strerror(errno) << endl;
+      return false;
+   }
+   dir = directory;
+   segmentSize = max(size, sizeof(EventSegment) + 4096);
+   keep = max(1u, segments);
+   vector<string> existing = event_segments(dir);
+   sequence = existing.empty() ? 0 : segment_sequence(existing.back().c_str() + dir.size() + 1);
+   if (!rotate()) {
+      return false;
+   }
+   tcout() << "Event log: " << dir << ", segment " << sequence << endl;
+   return true;
+}
+
+/** @brief Unmap the current segment, cut to its used size */
+void EventLog::close() {
+   if (!map) {
+      return;
+   }
+   munmap(map, segmentSize);
+   if (ftruncate(fd, offset) < 0) {
+      // the zeroed rest ends the segment as well
+   }
+   ::close(fd);
+   map = nullptr;
+   fd = -1;
+}
+
+/** @brief Continue in a new segment and drop the oldest ones, mutex held */
+bool EventLog::rotate() {
+   close();
+   string path = dir + "/" + prefix + to_string(++sequence);
+   fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+   if (fd < 0) {
+      tcerr() << "Event log: unable to create " << path << ": " << strerror(errno) << endl;
+      return false;
+   }
+   int error = posix_fallocate(fd, 0, segmentSize);
+   void* m = error ? MAP_FAILED : mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (m == MAP_FAILED) {
+      tcerr() << "Event log: unable to map " << path << ": " << strerror(error ? error : errno) << endl;
+      ::close(fd);
+      unlink(path.c_str());
+      fd = -1;
+      return false;
+   }
+   map = static_cast<char*>(m);
+   madvise(map, segmentSize, MADV_SEQUENTIAL);
+
+   EventSegment* header = reinterpret_cast<EventSegment*>(map);
+   memcpy(header->magic, magic, sizeof(magic));
+   header->version = EventSegment::current;
+   header->headerSize = sizeof(EventSegment);
+   header->sequence = sequence;
+   header->monotonic = now();
+   header->realtime = clock_ns(CLOCK_REALTIME);
+   offset = sizeof(EventSegment);
+
+   // every segment can be decoded on its own
+   uint64_t time = header->monotonic;
+   for (size_t id = 0; id < names.size(); ++id) {
+      append(EventPlc, 0, id, time, 0, 0, names[id].data(), names[id].size());
+   }
+
+   vector<string> existing = event_segments(dir);
+   for (size_t i = 0; i + keep < existing.size(); ++i) {
+      unlink(existing[i].c_str());
+   }
+   return true;
+}
+
+/** @brief Copy a record behind the last one, mutex held
+ * @return false if the segment is full
+ */
+bool EventLog::append(EventType type, uint8_t code, uint16_t plc, uint64_t time, int32_t value, int32_t detail,
+      const char* text, size_t length) {
+   length = min<size_t>(length, 1024);
+   size_t size = (sizeof(EventRecord) + length + 7) & ~size_t(7);
+   if (offset + size > segmentSize) {
+      return false;
+   }
+   EventRecord* r = reinterpret_cast<EventRecord*>(map + offset);
+   r->type = type;
+   r->code = code;
+   r->plc = plc;
+   r->length = length;
+   r->time = time;
+   r->value = value;
+   r->detail = detail;
+   memcpy(r + 1, text, length);
+   // the size makes the record visible, a reader of a crashed segment never sees half a record
+   __atomic_store_n(&r->size, (uint16_t) size, __ATOMIC_RELEASE);
+   offset += size;
+   return true;
+}
+
+void EventLog::record(EventType type, uint8_t code, uint16_t plc, int32_t value, int32_t detail, const char* text,
+      size_t length) {
+   uint64_t time = now();
+   lock_guard<std::mutex> lock(mutex);
+   if (map && !append(type, code, plc, time, value, detail, text, length) && rotate()) {
+      append(type, code, plc, time, value, detail, text, length);
+   }
+}
+
+uint16_t EventLog::plc(const string& name) {
+   uint16_t id;
+   {
+      lock_guard<std::mutex> lock(mutex);
+      id = names.size();
+      names.push_back(name);
+   }
+   record(EventPlc, 0, id, 0, 0, name.data(), name.size());
+   return id;
+}
+
+void EventLog::connect(uint16_t plc, int result, int latencyUs) {
+   record(EventConnect, 0, plc, result, latencyUs, "", 0);
+}
+
+void EventLog::status(uint16_t plc, int status, int previous, int event) {
+   record(EventStatus, previous, plc, status, event, "", 0);
+}
+
+void EventLog::push(uint16_t plc, int priority, const string& title) {
+   record(EventPush, 0, plc, priority, 0, title.data(), title.size());
+}
+
+void EventLog::receipt(uint16_t plc, EventReceiptState state, const string& receipt, int http) {
+   record(EventReceipt, state, plc, http, 0, receipt.data(), receipt.size());
+}
+
+void EventLog::hot_start(uint16_t plc, int result) {
+   record(EventHotStart, 0, plc, result, 0, "", 0);
+}
+
+EventReader::~EventReader() {
+   if (map) {
+      munmap(const_cast<char*>(map), size);
+   }
+}
+
+bool EventReader::open(const string& path, string& error) {
+   int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fd < 0) {
+      error = strerror(errno);
+      return false;
+   }
+   struct stat st;
+   if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(EventSegment)) {
+      error = "no event log segment";
+      ::close(fd);
+      return false;
+   }
+   void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   ::close(fd);
+   if (m == MAP_FAILED) {
+      error = strerror(errno);
+      return false;
+   }
+   map = static_cast<const char*>(m);
+   size = st.st_size;
+   madvise(const_cast<char*>(map), size, MADV_SEQUENTIAL);
+   if (memcmp(segment().magic, magic, sizeof(magic)) || segment().version != EventSegment::current
+         || segment().headerSize < sizeof(EventSegment) || segment().headerSize > size) {
+      error = "no event log segment of version " + to_string(EventSegment::current);
+      return false;
+   }
+   offset = segment().headerSize;
+   return true;
+}
@@ -0,0 +1,171 @@
+/*
+ * eventlog.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef EVENTS_EVENTLOG_H_
+#define EVENTS_EVENTLOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * The event log is a directory of segments named events.<sequence>, each a file of fixed size
+ * mapped into memory. A segment starts with an EventSegment header followed by the records; the
+ * first record of size 0 (the zeroed rest of the file) ends it. A segment closed cleanly is cut
+ * to its used size. All values are in host byte order.
+ */
+
+/** @brief Header of a segment */
+struct EventSegment {
+   char magic[8];           ///< "PLCEVLOG"
+   uint32_t version;        ///< EventSegment::current
+   uint32_t headerSize;     ///< offset of the first record
+   uint64_t sequence;       ///< number of the segment, counts up across restarts
+   uint64_t monotonic;      ///< CLOCK_MONOTONIC in ns when the segment was created
+   uint64_t realtime;       ///< CLOCK_REALTIME in ns at the same moment, maps the record times to wall time
+   uint8_t reserved[24];
+
+   static const uint32_t current = 1;
+};
+
+/** @brief Type of a record */
+enum EventType : uint8_t {
+   EventPlc = 1,   ///< text name of the plc the id stands for, repeated at the start of every segment
+   EventConnect,   ///< value result of the connect (0 or snap7 error), detail latency in µs
+   EventStatus,    ///< value cpu status, detail event id of the last transition, code previous mode
+   EventPush,      ///< value priority, text title
+   EventReceipt,   ///< code EventReceiptState, value HTTP status, text receipt
+   EventHotStart,  ///< value result of PlcHotStart()
+};
+
+/** @brief State of an emergency in an EventReceipt record */
+enum EventReceiptState : uint8_t {
+   ReceiptIssued = 0,    ///< pushover.net accepted the emergency
+   ReceiptFailed,        ///< the emergency was not delivered
+   ReceiptAcknowledged,
+   ReceiptExpired,
+   ReceiptCancelled,     ///< the plc left STOP by itself
+};
+
+/** @brief Record head, followed by length bytes of text and padded to 8 bytes */
+struct EventRecord {
+   uint16_t size;      ///< bytes of the record including head and padding, 0 ends the segment
+   uint8_t type;       ///< EventType
+   uint8_t code;
+   uint16_t plc;       ///< id of the plc, see EventPlc
+   uint16_t length;    ///< bytes of text
+   uint64_t time;      ///< CLOCK_MONOTONIC in ns
+   int32_t value;
+   int32_t detail;
+
+   const char* text() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+static_assert(sizeof(EventSegment) == 64, "segment header layout");
+static_assert(sizeof(EventRecord) == 24, "record layout");
+
+/** @brief Append-only binary log of typed events
+ *
+ * Recording copies a record into the mapped segment under a short lock, no system call is
+ * involved until the segment is full. The kernel writes the pages back, a crash of the daemon
+ * loses nothing that was recorded. The blocks of a segment are allocated with posix_fallocate()
+ * before it is mapped: a store into a page the file system can not back raises SIGBUS, a full
+ * disk shows up as an error of open() or of the rotation instead. Without open() all recording
+ * is a no-op.
+ */
+class EventLog {
+public:
+   EventLog();
+   /** @brief Cut the current segment to its used size */
+   ~EventLog();
+   EventLog(const EventLog&) = delete;
+   EventLog& operator=(const EventLog&) = delete;
+
+   /** @brief Start a new segment in directory, the oldest ones beyond segments are removed
+    * @param directory created if missing
+    * @param segmentSize size of a segment in bytes
+    * @param segments number of segments kept
+    * @return false if the log can not be written, errors are logged
+    */
+   bool open(const std::string& directory, size_t segmentSize = 16 << 20, unsigned segments = 8);
+   bool active() const { return map != nullptr; }
+
+   /** @brief Register a plc, the returned id is passed to the other calls */
+   uint16_t plc(const std::string& name);
+
+   void connect(uint16_t plc, int result, int latencyUs);
+   void status(uint16_t plc, int status, int previous, int event);
+   void push(uint16_t plc, int priority, const std::string& title);
+   void receipt(uint16_t plc, EventReceiptState state, const std::string& receipt, int http);
+   void hot_start(uint16_t plc, int result);
+
+   /** @brief Monotonic time stamp of the records in ns */
+   static uint64_t now();
+
+private:
+   void record(EventType type, uint8_t code, uint16_t plc, int32_t value, int32_t detail, const char* text,
+         size_t length);
+   bool append(EventType type, uint8_t code, uint16_t plc, uint64_t time, int32_t value, int32_t detail,
+         const char* text, size_t length);
+   bool rotate();
+   void close();
+
+   std::mutex mutex;
+   std::string dir;
+   size_t segmentSize = 0;
+   unsigned keep = 0;
+   uint64_t sequence = 0;
+   int fd = -1;
+   char* map = nullptr;
+   size_t offset = 0;       ///< end of the last record
+   std::vector<std::string> names;  ///< by plc id
+};
+
+/** @brief Reads the records of a segment file */
+class EventReader {
+public:
+   EventReader() = default;
+   ~EventReader();
+   EventReader(const EventReader&) = delete;
+   EventReader& operator=(const EventReader&) = delete;
+
+   /** @brief Map a segment
+    * @return false if it can not be read or is no segment, error describes why
+    */
+   bool open(const std::string& path, std::string& error);
+   const EventSegment& segment() const { return *reinterpret_cast<const EventSegment*>(map); }
+
+   /** @brief Next record, nullptr at the end or at a torn record */
+   const EventRecord* next() {
+      if (offset + sizeof(EventRecord) > size) {
+         return nullptr;
+      }
+      const EventRecord* r = reinterpret_cast<const EventRecord*>(map + offset);
+      if (r->size < sizeof(EventRecord) + r->length || offset + r->size > size) {
+         return nullptr;
+      }
+      offset += r->size;
+      return r;
+   }
+
+   /** @brief Wall time of a record in ns since the epoch */
+   uint64_t realtime(const EventRecord& r) const {
+      return segment().realtime + (r.time - segment().monotonic);
+   }
+
+private:
+   const char* map = nullptr;
+   size_t size = 0;
+   size_t offset = 0;
+};
+
+/** @brief Segment files of a directory ordered by sequence */
+std::vector<std::string> event_segments(const std::string& directory);
+
+#endif /* EVENTS_EVENTLOG_H_ */
@@ -0,0 +1,223 @@
+/*
+ * checkpoint.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+#include "checkpoint.h"
+#include "log.hpp"
+
+using namespace std;
+
+/*
+ * State file: header, then 'slots' slots of two records each, all in host order.
+ * A record is valid if its generation is not 0 and its crc32 matches, the valid one with the
+ * higher generation is the state of the slot. A record without name is a free slot.
+ */
+namespace {
+
+const char magic[8] = { 'P', 'L', 'C', 'S', 'T', 'A', 'T', 'E' };
+const uint32_t version = 1;
+
+enum : uint8_t {
+   ConnectError = 1, ConnectSuccess = 2, Run = 4
+};
+
+struct Header {
+   char magic[8];
+   uint32_t version;
+   uint32_t slots;
+   uint32_t recordSize;
+   uint8_t reserved[44];
+};
+
+/** @brief crc32 of data, continued from crc */
+uint32_t crc32(uint32_t crc, const void* data, size_t size) {
+   const uint8_t* bytes = static_cast<const uint8_t*>(data);
+   crc = ~crc;
+   for (size_t i = 0; i < size; ++i) {
+      crc ^= bytes[i];
+      for (int bit = 0; bit < 8; ++bit) {
+         crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+      }
+   }
+   return ~crc;
+}
+
+}
+
+struct Checkpoint::Record {
+   uint64_t generation;   ///< 0 never written, set last
+   uint32_t crc;          ///< of the generation and the bytes behind crc
+   uint8_t flags;
+   uint8_t nameLength;    ///< 0 for a free slot
+   uint8_t receiptLength;
+   int8_t status;
+   uint64_t eventTime;
+   uint16_t event;
+   uint8_t previous;
+   uint8_t reserved[5];
+   char name[64];
+   char receipt[32];      ///< pushover.net receipts have 30 characters
+
+   uint32_t checksum() const {
+      return crc32(crc32(0, &generation, sizeof(generation)), &flags, sizeof(Record) - offsetof(Record, flags));
+   }
+   bool valid() const {
+      return generation && crc == checksum() && nameLength < sizeof(name) && receiptLength <= sizeof(receipt);
+   }
+};
+
+struct Checkpoint::Slot {
+   Record copies[2];
+};
+
+static_assert(sizeof(Header) == 64, "state file header layout");
+
+Checkpoint::Checkpoint() {
+   static_assert(sizeof(Record) == 128, "state file record layout");
+}
+
+Checkpoint::~Checkpoint() {
+   if (map) {
+      msync(map, size, MS_ASYNC);
+      munmap(map, size);
+   }
+   if (fd >= 0) {
+      close(fd);
+   }
+}
+
+bool Checkpoint::open(const string& path) {
+   size = sizeof(Header) + slots * sizeof(Slot);
+   fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+   struct stat st;
+   if (fd < 0 || fstat(fd, &st) < 0) {
+      tcerr() << "State: unable to open " << path << ": " << strerror(errno) << endl;
+      return false;
+   }
+   bool fresh = (size_t) st.st_size != size;
+   // a file of another size is started over, its blocks allocated as for the EventLog segments
+   int error = (fresh && ftruncate(fd, 0) < 0) ? errno : posix_fallocate(fd, 0, size);
+   void* m = error ? MAP_FAILED : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (m == MAP_FAILED) {
+      tcerr() << "State: unable to map " << path << ": " << strerror(error ? error : errno) << endl;
+      return false;
+   }
+   map = static_cast<char*>(m);
+
+   Header* header = reinterpret_cast<Header*>(map);
+   if (!fresh && (memcmp(header->magic, magic, sizeof(magic)) || header->version != version
+         || header->slots != slots || header->recordSize != sizeof(Record))) {
+      tcerr() << "State: " << path << " is of another version, starting over" << endl;
+      fresh = true;
+   }
+   if (fresh) {
+      memset(map, 0, size);
+      memcpy(header->magic, magic, sizeof(magic));
+      header->version = version;
+      header->slots = slots;
+      header->recordSize = sizeof(Record);
+      msync(map, size, MS_SYNC);
+   }
+   size_t kept = 0;
+   for (size_t i = 0; i < slots; ++i) {
+      const Record* r = latest(*slot(i));
+      kept += r && r->nameLength;
+   }
+   tcout() << "State: " << kept << " plc(s) in " << path << endl;
+   return true;
+}
+
+Checkpoint::Slot* Checkpoint::slot(size_t index) const {
+   return reinterpret_cast<Slot*>(map + sizeof(Header)) + index;
+}
+
+/** @brief The current record of a slot, nullptr if none is valid */
+const Checkpoint::Record* Checkpoint::latest(const Slot& slot) {
+   const Record* a = slot.copies[0].valid() ? &slot.copies[0] : nullptr;
+   const Record* b = slot.copies[1].valid() ? &slot.copies[1] : nullptr;
+   if (a && b) {
+      return a->generation > b->generation ? a : b;
+   }
+   return a ? a : b;
+}
+
+size_t Checkpoint::attach(const string& name, WatchdogState& state) {
+   if (!map || name.size() >= sizeof(Record::name)) {
+      return npos;
+   }
+   lock_guard<std::mutex> lock(mutex);
+   size_t free = npos;
+   for (size_t i = 0; i < slots; ++i) {
+      const Record* r = latest(*slot(i));
+      if (!r || !r->nameLength) {
+         free = min(free, i);
+      } else if (name.compare(0, string::npos, r->name, r->nameLength) == 0) {
+         state.notifyConnectError = r->flags & ConnectError;
+         state.notifyConnectSuccess = r->flags & ConnectSuccess;
+         state.notifyRun = r->flags & Run;
+         state.receipt.assign(r->receipt, r->receiptLength);
+         state.status = r->status;
+         state.previous = r->previous;
+         state.event = r->event;
+         state.eventTime = r->eventTime;
+         return i;
+      }
+   }
+   if (free == npos) {
+      tcerr() << "State: no slot left for " << name << ", its state is not kept" << endl;
+      return npos;
+   }
+   Record* r = &slot(free)->copies[0];
+   r->nameLength = name.size();
+   memcpy(r->name, name.data(), name.size());
+   save(free, state);
+   return free;
+}
+
+void Checkpoint::release(size_t index) {
+   if (map && index < slots) {
+      lock_guard<std::mutex> lock(mutex);
+      memset(slot(index), 0, sizeof(Slot));
+   }
+}
+
+void Checkpoint::save(size_t index, const WatchdogState& state) {
+   if (!map || index >= slots) {
+      return;
+   }
+   Slot& s = *slot(index);
+   const Record* current = latest(s);
+   // the name is taken from the current record, or set by attach() on a free slot
+   const Record& named = current ? *current : s.copies[0];
+   Record* next = current == &s.copies[0] ? &s.copies[1] : &s.copies[0];
+   Record record;
+   memset(&record, 0, sizeof(record));
+   record.nameLength = named.nameLength;
+   memcpy(record.name, named.name, sizeof(record.name));
+   record.flags = (state.notifyConnectError ? ConnectError : 0) | (state.notifyConnectSuccess ? ConnectSuccess : 0)
+         | (state.notifyRun ? Run : 0);
+   record.receiptLength = min(state.receipt.size(), sizeof(record.receipt));
+   memcpy(record.receipt, state.receipt.data(), record.receiptLength);
+   record.status = state.status;
+   record.previous = state.previous;
+   record.event = state.event;
+   record.eventTime = state.eventTime;
+   record.generation = (current ? current->generation : 0) + 1;
+   record.crc = record.checksum();
+
+   // invalidate the older copy, write it, then publish it by its generation
+   __atomic_store_n(&next->generation, 0, __ATOMIC_RELEASE);
+   memcpy((char*) next + sizeof(record.generation), (const char*) &record + sizeof(record.generation),
+         sizeof(record) - sizeof(record.generation));
+   __atomic_store_n(&next->generation, record.generation, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,84 @@
+/*
+ * checkpoint.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef MAIN_CHECKPOINT_H_
+#define MAIN_CHECKPOINT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <string>
+
+/** @brief Notification state of a watchdog, what a restart has to resume */
+struct WatchdogState {
+   bool notifyConnectError = true;
+   bool notifyConnectSuccess = true;
+   bool notifyRun = true;
+   std::string receipt;   ///< open STOP emergency, empty for none
+   int status = -1;       ///< cpu status of the last status event, -1 for none
+   int previous = 0;      ///< last mode transition seen, see PlcHealth
+   uint16_t event = 0;
+   uint64_t eventTime = 0;
+
+   bool operator==(const WatchdogState& other) const {
+      return notifyConnectError == other.notifyConnectError && notifyConnectSuccess == other.notifyConnectSuccess
+            && notifyRun == other.notifyRun && receipt == other.receipt && status == other.status
+            && previous == other.previous && event == other.event && eventTime == other.eventTime;
+   }
+   bool operator!=(const WatchdogState& other) const { return !(*this == other); }
+};
+
+/** @brief Keeps the state of the watchdogs across restarts in a memory-mapped file
+ *
+ * The file holds a versioned header and a slot per plc. A slot has two copies of its record, each
+ * with a generation and a checksum; a save overwrites the older copy and sets its generation last,
+ * so the newer valid copy is always complete, even after a torn write. The file is mapped like a
+ * segment of the EventLog, a save is a store into the mapping; it survives a crash of the daemon,
+ * a power loss may cost the saves since the last writeback. Without open() nothing is kept.
+ */
+class Checkpoint {
+public:
+   static const size_t slots = 1024;
+
+   Checkpoint();
+   ~Checkpoint();
+   Checkpoint(const Checkpoint&) = delete;
+   Checkpoint& operator=(const Checkpoint&) = delete;
+
+   /** @brief Map the state file
+    * @param path created if missing, started over if it is of another version
+    * @return false if it can not be written, errors are logged
+    */
+   bool open(const std::string& path);
+
+   /** @brief Slot of a plc, the state of the last run is restored into state
+    * @param name name of the plc, at most 63 characters
+    * @param state untouched if nothing was saved for the plc
+    * @return slot or npos if there is none
+    */
+   size_t attach(const std::string& name, WatchdogState& state);
+   /** @brief Forget a plc, e.g. removed from the configuration */
+   void release(size_t slot);
+   /** @brief Save the state of a plc, from the thread running its cycles */
+   void save(size_t slot, const WatchdogState& state);
+
+   static const size_t npos = (size_t) -1;
+
+private:
+   struct Record;
+   struct Slot;
+
+   Slot* slot(size_t index) const;
+   static const Record* latest(const Slot& slot);
+
+   std::mutex mutex;  ///< slot allocation
+   int fd = -1;
+   char* map = nullptr;
+   size_t size = 0;
+};
+
+#endif /* MAIN_CHECKPOINT_H_ */
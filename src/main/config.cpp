@@ -0,0 +1,225 @@
+/*
+ * config.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <fstream>
+#include <set>
+#include <unordered_set>
+#include <math.h>
+#include <stdlib.h>
+#include "config.h"
+#include "log.hpp"
+
+using namespace std;
+
+typedef vector<pair<string, string>> Section;
+
+static string trim(const string& s) {
+   const char* ws = " \t\r\n";
+   size_t begin = s.find_first_not_of(ws);
+   if (begin == string::npos) {
+      return string();
+   }
+   return s.substr(begin, s.find_last_not_of(ws) - begin + 1);
+}
+
+static bool to_int(const string& value, int& result) {
+   char* end = NULL;
+   long l = strtol(value.c_str(), &end, 10);
+   if (value.empty() || *end != '\0') {
+      return false;
+   }
+   result = (int) l;
+   return true;
+}
+
+bool parse_duration(const string& value, chrono::milliseconds& duration) {
+   char* end = NULL;
+   double d = strtod(value.c_str(), &end);
+   if (value.empty() || end == value.c_str() || !isfinite(d) || d <= 0) {
+      return false;
+   }
+   string unit(end);
+   if (unit.empty() || unit == "s") {
+      d *= 1000;
+   } else if (unit == "m") {
+      d *= 60000;
+   } else if (unit != "ms") {
+      return false;
+   }
+   // the scheduler works in nanoseconds, the duration has to fit in there
+   static const double longest = chrono::duration_cast<chrono::milliseconds>(chrono::nanoseconds::max()).count();
+   if (d < 1 || d > longest) {
+      return false;
+   }
+   duration = chrono::milliseconds((long long) d);
+   return true;
+}
+
+/** @brief Parse "name address" of a tag key */
+static bool parse_tag(const string& value, PlcConfig& plc) {
+   size_t sep = value.find_first_of(" \t");
+   if (sep == string::npos) {
+      return false;
+   }
+   TagConfig tag;
+   tag.name = value.substr(0, sep);
+   if (!parse_tag_address(trim(value.substr(sep)).c_str(), tag.address)) {
+      return false;
+   }
+   plc.tags.push_back(tag);
+   return true;
+}
+
+/** @brief Apply the keys of a section onto a plc configuration
+ * @param plcSection true for [plc] sections, which may list tags
+ * @return false if a key is unknown or a value is invalid
+ */
+static bool apply(const Section& section, PlcConfig& plc, bool plcSection, const char* file) {
+   for (const auto& kv : section) {
+      const string& key = kv.first;
+      const string& value = kv.second;
+      bool ok = true;
+      if (key == "ip") {
+         plc.ip = value;
+      } else if (key == "rack") {
+         ok = to_int(value, plc.rack);
+      } else if (key == "slot") {
+         ok = to_int(value, plc.slot);
+      } else if (key == "polling") {
+         ok = parse_duration(value, plc.pollingRate);
+      } else if (key == "key") {
+         plc.pushover.key = value;
+      } else if (key == "token") {
+         plc.pushover.token = value;
+      } else if (key == "retry") {
+         plc.pushover.retry = value;
+      } else if (key == "expire") {
+         plc.pushover.expire = value;
+      } else if (key == "device") {
+         plc.pushover.device = value;
+      } else if (key == "callback") {
+         plc.pushover.callback = value;
+      } else if (key == "tag" && plcSection) {
+         ok = parse_tag(value, plc);
+      } else {
+         tcerr() << file << ": unknown key '" << key << "'" << endl;
+         return false;
+      }
+      if (!ok) {
+         tcerr() << file << ": invalid value '" << value << "' for key '" << key << "'" << endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+bool load_config(const char* file, Config& config) {
+   ifstream in(file);
+   if (!in) {
+      tcerr() << file << ": unable to open configuration" << endl;
+      return false;
+   }
+
+   // collect raw key/value pairs first, sections may appear in any order
+   Section global;
+   vector<pair<string, Section>> plcs;
+   set<string> names;
+   Section* current = &global;
+   string line;
+   for (int lineNo = 1; getline(in, line); ++lineNo) {
+      line = trim(line);
+      if (line.empty() || line[0] == '#' || line[0] == ';') {
+         continue;
+      }
+      if (line[0] == '[') {
+         if (line[line.size() - 1] != ']') {
+            tcerr() << file << ":" << lineNo << ": malformed section" << endl;
+            return false;
+         }
+         string section = trim(line.substr(1, line.size() - 2));
+         if (section == "pushover") {
+            current = &global;
+         } else if (section.compare(0, 4, "plc ") == 0 && !trim(section.substr(4)).empty()) {
+            string name = trim(section.substr(4));
+            if (!names.insert(name).second) {
+               tcerr() << file << ":" << lineNo << ": duplicate plc '" << name << "'" << endl;
+               return false;
+            }
+            plcs.emplace_back(name, Section());
+            current = &plcs.back().second;
+         } else {
+            tcerr() << file << ":" << lineNo << ": unknown section '" << section << "'" << endl;
+            return false;
+         }
+         continue;
+      }
+      size_t eq = line.find('=');
+      if (eq == string::npos) {
+         tcerr() << file << ":" << lineNo << ": expected key = value" << endl;
+         return false;
+      }
+      current->emplace_back(trim(line.substr(0, eq)), trim(line.substr(eq + 1)));
+   }
+
+   // the receiver and the API are shared by all plcs
+   for (auto it = global.begin(); it != global.end();) {
+      if (it->first == "listen") {
+         config.listen = it->second;
+         it = global.erase(it);
+      } else if (it->first == "api") {
+         config.api = it->second;
+         it = global.erase(it);
+      } else if (it->first == "notify") {
+         config.notify.push_back(it->second);
+         it = global.erase(it);
+      } else if (it->first == "outbox") {
+         config.outbox = it->second;
+         it = global.erase(it);
+      } else if (it->first == "events") {
+         config.events = it->second;
+         it = global.erase(it);
+      } else if (it->first == "state") {
+         config.state = it->second;
+         it = global.erase(it);
+      } else if (it->first == "coalesce") {
+         if (it->second == "0") {
+            config.coalesce = chrono::milliseconds::zero();
+         } else if (!parse_duration(it->second, config.coalesce)) {
+            tcerr() << file << ": invalid value '" << it->second << "' for key 'coalesce'" << endl;
+            return false;
+         }
+         it = global.erase(it);
+      } else {
+         ++it;
+      }
+   }
+   if (!apply(global, config.defaults, false, file)) {
+      return false;
+   }
+   for (const auto& section : plcs) {
+      PlcConfig plc = config.defaults;
+      plc.name = section.first;
+      plc.ip.clear();
+      plc.tags.clear();
+      if (!apply(section.second, plc, true, file)) {
+         return false;
+      }
+      if (plc.ip.empty() || plc.pushover.key.empty() || plc.pushover.token.empty()) {
+         tcerr() << file << ": plc '" << plc.name << "' needs ip, key and token" << endl;
+         return false;
+      }
+      unordered_set<string> tagNames;
+      for (const TagConfig& tag : plc.tags) {
+         if (!tagNames.insert(tag.name).second) {
+            tcerr() << file << ": plc '" << plc.name << "' has duplicate tag '" << tag.name << "'" << endl;
+            return false;
+         }
+      }
+      config.plcs.push_back(plc);
+   }
+   return true;
+}
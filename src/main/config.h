@@ -0,0 +1,123 @@
+/*
+ * config.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef MAIN_CONFIG_H_
+#define MAIN_CONFIG_H_
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "tag.h"
+
+/** @brief pushover.net parameters used for the notifications of a plc */
+struct PushoverConfig {
+   std::string key;           ///< pushover.net user key
+   std::string token;         ///< pushover.net application token
+   std::string retry = "60";  ///< pushover.net retry parameter in seconds
+   std::string expire = "600";///< pushover.net expire parameter in seconds
+   std::string device;        ///< pushover.net device list e.g. dev1,dev2, empty for all devices
+   std::string callback;      ///< URL receiving the acknowledgements, empty to poll the receipts only
+};
+
+/** @brief A named tag of a plc */
+struct TagConfig {
+   std::string name;
+   TagAddress address;
+};
+
+/** @brief A single watched plc */
+struct PlcConfig {
+   std::string name;          ///< name used in logs and notifications, empty for the command line plc
+   std::string ip;            ///< address of the plc
+   int rack = 0;
+   int slot = 2;
+   std::chrono::milliseconds pollingRate = std::chrono::seconds(10); ///< polling rate of the plc state
+   PushoverConfig pushover;
+   std::vector<TagConfig> tags; ///< values read and logged on change every cycle
+};
+
+inline bool operator==(const PushoverConfig& a, const PushoverConfig& b) {
+   return a.key == b.key && a.token == b.token && a.retry == b.retry && a.expire == b.expire && a.device == b.device
+         && a.callback == b.callback;
+}
+
+inline bool operator==(const TagConfig& a, const TagConfig& b) {
+   return a.name == b.name && a.address == b.address;
+}
+
+inline bool operator==(const PlcConfig& a, const PlcConfig& b) {
+   return a.name == b.name && a.ip == b.ip && a.rack == b.rack && a.slot == b.slot && a.pollingRate == b.pollingRate
+         && a.pushover == b.pushover && a.tags == b.tags;
+}
+
+/** @brief Fleet configuration */
+struct Config {
+   PlcConfig defaults;        ///< values used for keys missing in a [plc] section
+   std::vector<PlcConfig> plcs;
+   std::string listen;        ///< "[address:]port" of the callback receiver, empty for none
+   std::string api;           ///< base URL of the pushover.net API, empty for the default
+   std::chrono::milliseconds coalesce = std::chrono::seconds(2); ///< window merging the notifications of several plcs
+   std::string outbox;        ///< journal of the undelivered notifications and open receipts, empty for none
+   std::vector<std::string> notify; ///< backends besides pushover.net, see create_notifier()
+   std::string events;        ///< directory of the binary event log, empty for none
+   std::string state;         ///< state file of the watchdogs for warm restarts, empty for none
+};
+
+/** @brief Parse a duration like "250ms", "2s" or "1m", a plain number means seconds
+ * @param value text to parse
+ * @param duration parsed duration, only set on success
+ * @return true if value is a positive duration
+ */
+bool parse_duration(const std::string& value, std::chrono::milliseconds& duration);
+
+/** @brief Load a fleet configuration file
+ *
+ * The file is organized in sections, empty lines and lines starting with '#' or ';' are ignored.
+ * @code
+ * polling = 10
+ * listen = 8080
+ * coalesce = 2s
+ * outbox = /var/lib/plcwatchd/outbox
+ * events = /var/lib/plcwatchd/events
+ * state = /var/lib/plcwatchd/state
+ * notify = syslog
+ * notify = webhook:https://example.org/plc
+ *
+ * [pushover]
+ * key = <user key>
+ * token = <application token>
+ * retry = 60
+ * expire = 600
+ * device = dev1,dev2
+ * callback = https://plcwatchd.example.org/pushover
+ *
+ * [plc hall]
+ * ip = 192.168.178.105
+ * rack = 0
+ * slot = 2
+ * polling = 250ms
+ * key = <user key of the recipients of this plc>
+ * device = dev3
+ * tag = temperature DB10.DBD4:REAL
+ * tag = pump M12.3
+ * @endcode
+ * A tag is given as name and address, see parse_tag_address() for the address syntax.
+ * listen, api, coalesce, outbox, events, state and notify are top level keys only, they start the receiver of the
+ * callback URL, set the base URL of the API (e.g. http://localhost:8081/1 for pushover-mock), the window merging the
+ * notifications of several plcs into one message (0 sends each at once), the journal keeping the
+ * undelivered notifications and open receipts across restarts, the directory of the binary event log
+ * (see plcwatchd-log) and the file keeping the notification state of the plcs across restarts. notify may be given several times, every notification is delivered to these backends
+ * too (webhook:<url>, syslog[:<ident>], socket:<path>).
+ * Keys missing in a [plc] section are taken from config.defaults, which is pre-filled by the caller
+ * (command line) and overwritten by the top level and [pushover] keys of the file.
+ * @param file path of the configuration file
+ * @param config configuration to fill, plcs are appended
+ * @return true on success, errors are logged
+ */
+bool load_config(const char* file, Config& config);
+
+#endif /* MAIN_CONFIG_H_ */
@@ -1,21 +1,388 @@
-#ifndef _LOG_HPP_
-#define _LOG_HPP_
-
-#include <iostream>
-#include <fstream>
-
-inline std::ostream & tcout() {
-   time_t t = time(0);
-   struct tm *now = localtime( &t );
-   std::cout << 1900 + now->tm_year << "-" << 1 + now->tm_mon << "-" << now->tm_mday << " " << now->tm_hour << ":" << now->tm_min << ":" << now->tm_sec << ": ";
-   return std::cout;
-}
-
-inline std::ostream & tcerr() {
-   time_t t = time(0);
-   struct tm *now = localtime( &t );
-   std::cerr << 1900 + now->tm_year << "-" << 1 + now->tm_mon << "-" << now->tm_mday << " " << now->tm_hour << ":" << now->tm_min << ":" << now->tm_sec << ": ";
-   return std::cerr;
-}
-
-#endif
\ No newline at end of file
+#ifndef _LOG_HPP_
+#define _LOG_HPP_
+
+#include <sys/uio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * tcout() and tcerr() return a stream of the calling thread, the line is handed over by endl.
+ * Until Logger::start() the line is written to std::cout / std::cerr right away. Afterwards it is
+ * copied into a lock-free ring of the thread and a background thread writes the rings of all
+ * threads with a single writev() per batch, so a thread logging never waits for the disk.
+ */
+namespace logging {
+
+/** @brief Single producer single consumer byte ring of one thread and stream */
+class Ring {
+public:
+   static const size_t capacity = 1 << 18;
+
+   explicit Ring(int fd) :
+         fd(fd), buffer(new char[capacity]) {
+   }
+
+   /** @brief Append a complete line, producer only
+    * @return false if the ring has no room for it
+    */
+   bool push(const char* data, size_t size) {
+      size_t h = head.load(std::memory_order_relaxed);
+      if (capacity - (h - tail.load(std::memory_order_acquire)) < size) {
+         return false;
+      }
+      size_t at = h & (capacity - 1);
+      size_t first = std::min(size, capacity - at);
+      memcpy(buffer.get() + at, data, first);
+      memcpy(buffer.get(), data + first, size - first);
+      head.store(h + size, std::memory_order_release);
+      return true;
+   }
+
+   /** @brief Describe the unread bytes, consumer only
+    * @return number of io vectors used, at most two
+    */
+   int peek(struct iovec* iov, size_t& size) const {
+      size_t t = tail.load(std::memory_order_relaxed);
+      size = head.load(std::memory_order_acquire) - t;
+      if (!size) {
+         return 0;
+      }
+      size_t at = t & (capacity - 1);
+      size_t first = std::min(size, capacity - at);
+      iov[0].iov_base = buffer.get() + at;
+      iov[0].iov_len = first;
+      if (first == size) {
+         return 1;
+      }
+      iov[1].iov_base = buffer.get();
+      iov[1].iov_len = size - first;
+      return 2;
+   }
+
+   /** @brief Drop bytes written, consumer only */
+   void release(size_t size) {
+      tail.store(tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+   }
+
+   const int fd;
+   std::atomic<bool> closed { false };  ///< the thread ended, removed once drained
+
+private:
+   std::unique_ptr<char[]> buffer;
+   alignas(64) std::atomic<size_t> head { 0 };
+   alignas(64) std::atomic<size_t> tail { 0 };
+};
+
+/** @brief Writes the lines of all threads */
+class Logger {
+public:
+   /** @brief The process wide logger, never destroyed so threads may log while the process exits */
+   static Logger& instance() {
+      static Logger* logger = new Logger;
+      return *logger;
+   }
+
+   /** @brief Write asynchronously from now on, call after the output has been redirected and forked */
+   void start() {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (active) {
+         return;
+      }
+      std::cout.flush();
+      std::cerr.flush();
+      active = true;
+      thread = std::thread(&Logger::run, this);
+      atexit([] {
+         Logger::instance().stop();
+      });
+   }
+
+   /** @brief Write the pending lines and return to synchronous writes */
+   void stop() {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (!active) {
+            return;
+         }
+         active = false;
+      }
+      wake.notify_all();
+      thread.join();
+   }
+
+   /** @brief Point stdout and stderr at path again, e.g. after logrotate moved the file
+    *
+    * The descriptors are swapped atomically with dup2(), no line is lost while the file changes.
+    * @return false if path can not be opened
+    */
+   static bool reopen(const char* path) {
+      int fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+      if (fd < 0) {
+         return false;
+      }
+      std::cout.flush();
+      std::cerr.flush();
+      bool ok = dup2(fd, STDOUT_FILENO) >= 0 && dup2(fd, STDERR_FILENO) >= 0;
+      close(fd);
+      return ok;
+   }
+
+   /** @brief Hand over a line of the calling thread */
+   void write(int fd, const char* data, size_t size) {
+      if (active.load(std::memory_order_acquire) && size <= Ring::capacity) {
+         Ring& r = ring(fd);
+         bool pushed;
+         while (!(pushed = r.push(data, size)) && active.load(std::memory_order_acquire)) {
+            // full, the background thread is behind, wait for it instead of losing the line
+            wake.notify_one();
+            std::this_thread::yield();
+         }
+         if (pushed) {
+            if (sleeping.load(std::memory_order_relaxed)) {
+               sleeping.store(false, std::memory_order_relaxed);
+               wake.notify_one();
+            }
+            return;
+         }
+      }
+      std::ostream& out = fd == STDERR_FILENO ? std::cerr : std::cout;
+      out.write(data, size);
+      out.flush();
+   }
+
+private:
+   Ring& ring(int fd);
+
+   /** @brief Background thread, writes all rings until stopped and drained */
+   void run() {
+      std::vector<std::shared_ptr<Ring>> current;
+      std::vector<struct iovec> iov;
+      std::vector<size_t> sizes;
+      for (;;) {
+         bool stopping = !active.load(std::memory_order_acquire);
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            current.assign(rings.begin(), rings.end());
+         }
+         bool wrote = false;
+         for (int fd : { STDOUT_FILENO, STDERR_FILENO }) {
+            iov.clear();
+            sizes.assign(current.size(), 0);
+            for (size_t i = 0; i < current.size() && iov.size() + 2 <= IOV_MAX; ++i) {
+               if (current[i]->fd == fd) {
+                  struct iovec v[2];
+                  int n = current[i]->peek(v, sizes[i]);
+                  iov.insert(iov.end(), v, v + n);
+               }
+            }
+            if (iov.empty()) {
+               continue;
+            }
+            write_all(fd, iov);
+            for (size_t i = 0; i < current.size(); ++i) {
+               if (sizes[i]) {
+                  current[i]->release(sizes[i]);
+               }
+            }
+            wrote = true;
+         }
+         if (wrote) {
+            continue;
+         }
+         // forget the rings of ended threads once they are drained
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto it = rings.begin(); it != rings.end();) {
+               struct iovec v[2];
+               size_t size;
+               if ((*it)->closed && !(*it)->peek(v, size)) {
+                  it = rings.erase(it);
+               } else {
+                  ++it;
+               }
+            }
+         }
+         if (stopping) {
+            break;
+         }
+         std::unique_lock<std::mutex> lock(mutex);
+         sleeping.store(true, std::memory_order_relaxed);
+         // a line pushed while going to sleep is picked up by the timeout at the latest
+         wake.wait_for(lock, std::chrono::milliseconds(100));
+         sleeping.store(false, std::memory_order_relaxed);
+      }
+   }
+
+   static void write_all(int fd, std::vector<struct iovec>& iov) {
+      struct iovec* v = iov.data();
+      int count = iov.size();
+      while (count > 0) {
+         ssize_t n = writev(fd, v, count);
+         if (n < 0 && errno == EINTR) {
+            continue;
+         }
+         if (n < 0) {
+            return; // nowhere to report it
+         }
+         while (count > 0 && (size_t) n >= v->iov_len) {
+            n -= v->iov_len;
+            ++v;
+            --count;
+         }
+         if (count > 0) {
+            v->iov_base = (char*) v->iov_base + n;
+            v->iov_len -= n;
+         }
+      }
+   }
+
+   std::mutex mutex;
+   std::condition_variable wake;
+   std::vector<std::shared_ptr<Ring>> rings;
+   std::atomic<bool> active { false };
+   std::atomic<bool> sleeping { false };
+   std::thread thread;
+};
+
+/** @brief Collects a line in place, endl hands it to the logger */
+class LineBuffer: public std::streambuf {
+public:
+   explicit LineBuffer(int fd) :
+         fd(fd) {
+      setp(area, area + sizeof(area));
+   }
+   bool pending() const {
+      return pptr() != pbase() || !spill.empty();
+   }
+
+protected:
+   int overflow(int c) override {
+      spill.append(pbase(), pptr() - pbase());
+      setp(area, area + sizeof(area));
+      if (c != traits_type::eof()) {
+         *pptr() = (char) c;
+         pbump(1);
+      }
+      return traits_type::not_eof(c);
+   }
+   int sync() override {
+      if (!pending()) {
+         return 0;
+      }
+      if (spill.empty()) {
+         Logger::instance().write(fd, pbase(), pptr() - pbase());
+      } else {
+         spill.append(pbase(), pptr() - pbase());
+         Logger::instance().write(fd, spill.data(), spill.size());
+         spill.clear();
+      }
+      setp(area, area + sizeof(area));
+      return 0;
+   }
+
+private:
+   const int fd;
+   char area[512];
+   std::string spill;  ///< start of a line longer than area
+};
+
+/** @brief Logging state of a thread
+ *
+ * Deleted by a pthread key when the thread ends. The main thread keeps it through exit(), so the
+ * destructors of static objects may still log.
+ */
+struct Local {
+   LineBuffer outBuffer { STDOUT_FILENO }, errBuffer { STDERR_FILENO };
+   std::ostream out { &outBuffer }, err { &errBuffer };
+   std::shared_ptr<Ring> outRing, errRing;
+   time_t second = -1;  ///< the prefix only changes once a second
+   char stamp[32];
+   int stampSize = 0;
+
+   ~Local() {
+      if (outRing) {
+         outRing->closed = true;
+      }
+      if (errRing) {
+         errRing->closed = true;
+      }
+   }
+
+   static Local& get() {
+      static pthread_key_t key = [] {
+         pthread_key_t k;
+         pthread_key_create(&k, [](void* local) {
+            delete static_cast<Local*>(local);
+         });
+         return k;
+      }();
+      static thread_local Local* local = nullptr;
+      if (!local) {
+         local = new Local;
+         pthread_setspecific(key, local);
+      }
+      return *local;
+   }
+};
+
+inline Ring& Logger::ring(int fd) {
+   Local& local = Local::get();
+   std::shared_ptr<Ring>& r = fd == STDERR_FILENO ? local.errRing : local.outRing;
+   if (!r) {
+      r = std::make_shared<Ring>(fd);
+      std::lock_guard<std::mutex> lock(mutex);
+      rings.push_back(r);
+   }
+   return *r;
+}
+
+/** @brief Stream of the calling thread starting a new line with the time stamp */
+inline std::ostream& line(int fd) {
+   Local& local = Local::get();
+   std::ostream& s = fd == STDERR_FILENO ? local.err : local.out;
+   LineBuffer& buffer = fd == STDERR_FILENO ? local.errBuffer : local.outBuffer;
+   if (buffer.pending()) {
+      // previous line without endl
+      s.flush();
+   }
+   struct timespec now;
+   clock_gettime(CLOCK_REALTIME_COARSE, &now);
+   if (now.tv_sec != local.second) {
+      struct tm t;
+      localtime_r(&now.tv_sec, &t);
+      local.second = now.tv_sec;
+      local.stampSize = snprintf(local.stamp, sizeof(local.stamp), "%d-%d-%d %d:%d:%d: ", 1900 + t.tm_year,
+            1 + t.tm_mon, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+   }
+   s.write(local.stamp, local.stampSize);
+   return s;
+}
+
+}
+
+inline std::ostream & tcout() {
+   return logging::line(STDOUT_FILENO);
+}
+
+inline std::ostream & tcerr() {
+   return logging::line(STDERR_FILENO);
+}
+
+#endif
@@ -3,43 +3,121 @@
 #include <unistd.h>
 #include <string.h>
 #include <csignal>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <ctime>
-#include "snap7.h"
-#include "pushover.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+#include "asyncpoller.h"
+#include "backends.h"
+#include "callback.h"
+#include "checkpoint.h"
+#include "config.h"
+#include "eventlog.h"
+#include "fanout.h"
+#include "scheduler.h"
+#include "threadpool.h"
+#include "watchdog.h"
 #include "log.hpp"
 
 using namespace std;
 
-static TS7Client s7Client;
+static vector<unique_ptr<Watchdog>> watchdogs;
+// removed by a reload, late answers of their requests may still refer to them
+static vector<unique_ptr<Watchdog>> retired;
 
-/** @brief check the snap7 library function result and printout the related error message
- * @param result error code
- * @param function Name of the function the result is from
+// time the notifications queued on SIGTERM / SIGINT get to be delivered
+static const chrono::seconds shutdownTimeout(10);
+
+// working directory at start, daemonize() changes to /
+static string startDirectory;
+
+/** @brief Make the files of the configuration independent of the working directory
+ *
+ * Relative paths are taken relative to startDirectory. realpath() is of no use here, the files
+ * may not exist before the first start.
  */
-static bool check(int result, const char * function) {
-   if (result != 0) {
-      if (result < 0) {
-         tcerr() << function << ": library error (-1)" << endl;
-      } else {
-         tcerr() << function << ": " << CliErrorText(result) << endl;
+static void resolve_paths(Config& config) {
+   for (string* path : { &config.outbox, &config.events, &config.state }) {
+      if (!path->empty() && (*path)[0] != '/') {
+         *path = startDirectory + "/" + *path;
       }
    }
-   return result == 0;
 }
 
-/** @brief Cleanup Snap7 connection and exit
- * @param s Received signal
+/** @brief Apply the changes of the configuration file, called by the scheduler between two cycles
+ *
+ * The plcs are matched by name. A plc with the same address keeps its session, open emergency and
+ * notification state and only takes over the changed parameters, the others are stopped or started.
+ * The shared services (receiver, API, outbox, event log, state file, backends, coalescing) change on restart only.
+ * @param commandLine configuration given on the command line, the file is applied on top of it
+ * @param config current configuration, updated
+ * @param start starts watching an added plc
  */
-static void signal_handler(int s) {
-   tcout() << "SIG " << s << " (" << strsignal(s) << ") received!" << endl;
-   if (s7Client.Connected()) {
-      tcout() << "Disconnect from PLC" << endl;
-      check(s7Client.Disconnect(), "s7Client.Disconnect()");
+static void reload(const char* file, const Config& commandLine, Config& config, Scheduler& scheduler,
+      const function<void(const PlcConfig&)>& start) {
+   chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+   Config next = commandLine;
+   if (!load_config(file, next) || next.plcs.empty()) {
+      tcerr() << "Reload: " << file << " not applied, keeping the current configuration" << endl;
+      return;
    }
-   exit(EXIT_FAILURE);
+   resolve_paths(next);
+   if (next.listen != config.listen || next.api != config.api || next.outbox != config.outbox
+         || next.events != config.events || next.state != config.state || next.notify != config.notify
+         || next.coalesce != config.coalesce) {
+      tcerr() << "Reload: listen, api, outbox, events, state, notify and coalesce change on restart only" << endl;
+   }
+
+   size_t added = 0, changed = 0, removed = 0;
+   for (auto it = watchdogs.begin(); it != watchdogs.end();) {
+      const PlcConfig& current = (*it)->config();
+      const string name = current.name.empty() ? current.ip : current.name;
+      auto match = find_if(next.plcs.begin(), next.plcs.end(), [&current](const PlcConfig& plc) {
+         return plc.name == current.name;
+      });
+      if (match != next.plcs.end() && match->ip == current.ip && match->rack == current.rack
+            && match->slot == current.slot) {
+         if (!(*match == current)) {
+            bool faster = match->pollingRate < current.pollingRate;
+            (*it)->reconfigure(*match);
+            if (faster) {
+               scheduler.reschedule(it->get());
+            }
+            tcout() << name << ": Configuration changed, session kept" << endl;
+            ++changed;
+         }
+         ++it;
+         continue;
+      }
+      scheduler.remove(it->get());
+      (*it)->shutdown(false);
+      (*it)->forget();
+      tcout() << name << ": Stop state polling" << endl;
+      retired.push_back(move(*it));
+      it = watchdogs.erase(it);
+      ++removed;
+   }
+   for (const PlcConfig& plc : next.plcs) {
+      if (find_if(watchdogs.begin(), watchdogs.end(), [&plc](const unique_ptr<Watchdog>& watchdog) {
+         return watchdog->config().name == plc.name;
+      }) == watchdogs.end()) {
+         start(plc);
+         ++added;
+      }
+   }
+   config.defaults = next.defaults;
+   config.plcs = next.plcs;
+   tcout() << "Reload: " << added << " added, " << changed << " changed, " << removed << " removed, "
+         << watchdogs.size() << " plc(s) in "
+         << chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - begin).count() << " us" << endl;
 }
 
 /** @brief Fork process to background
@@ -91,49 +169,60 @@ void daemonize() {
 }
 
 static void usage() {
-   cout << "Usage: plcwatchd [-v] [-d] -k key -t token -i ip "
-         << "[-r num] [-s num] [-c sec] [-e sec] [-p sec] [-l file] [-u user]"<< endl << endl
+   cout << "Usage: plcwatchd [-v] [-d] [-a] -k key -t token -i ip "
+         << "[-r num] [-s num] [-c sec] [-e sec] [-p rate] [-l file] [-u user] [-w num] [-b url -L port] [-A url] [-g window] [-o file] [-E dir] [-S file] [-N backend]"<< endl
+         << "       plcwatchd [-v] [-d] [-a] -f file [-k key] [-t token] [-c sec] [-e sec] [-p rate] [-l file] [-u user] [-w num] [-b url -L port] [-A url] [-g window] [-o file] [-E dir] [-S file] [-N backend]"<< endl << endl
          << "  -v   verbose" << endl
          << "  -d   daemonize" << endl
-         << "  -p   polling rate of the PLC state in seconds, default 10" << endl
+         << "  -a   read the PLC state asynchronously, only connects and notifications use the workers" << endl
+         << "  -f   file - configuration of the watched plcs, see README.md" << endl
+         << "  -p   polling rate of the PLC state e.g. 250ms, 2s, plain numbers are seconds, default 10" << endl
          << "  -k   key - pushover.net user key" << endl
          << "  -t   token - pushover.net appliacation token" << endl
          << "  -c   retry - pushover.net retry parameter in seconds, default 60" << endl
          << "  -e   expire - pushover.net expire parameter in seconds, default 600" << endl
          << "  -u   user - pushover.net device list e.g. dev1,dev2, default all devices" << endl
+         << "  -b   url - pushover.net callback URL of the emergencies, receipts are polled every minute only" << endl
+         << "  -L   [address:]port - receive the callbacks on this port" << endl
+         << "  -A   url - base URL of the pushover.net API, default " << Pushover::defaultApi << endl
+         << "  -g   window - merge the notifications of several plcs within this window, 0 sends each at once, default 2s" << endl
+         << "  -o   file - journal of the undelivered notifications and open receipts, kept across restarts" << endl
+         << "  -E   dir - binary event log of connects, cpu states, notifications and receipts, see plcwatchd-log" << endl
+         << "  -S   file - notification state of the plcs, a restart resumes where the last run stopped" << endl
+         << "  -N   backend - deliver the notifications to webhook:<url>, syslog[:<ident>] or socket:<path> too" << endl
          << "  -i   ip - address of the plc" << endl
          << "  -r   rack - rack of the plc, default 0" << endl
          << "  -s   slot - slot of the plc, default 2" << endl
-         << "  -l   logfile" << endl;
+         << "  -l   logfile" << endl
+         << "  -w   workers - number of poller threads, default twice the number of cores" << endl;
 }
 
 int main(int argc, char *argv[]) {
 
-   int rack = 0;
-   int slot = 2;
-   int pollingRate = 10; //seconds
-   const char* retry = "60";
-   const char* expire = "600";
-   char* ip = NULL;
-   char* key = NULL;
-   char* token = NULL;
-   char* device = NULL;
+   Config config;
+   PlcConfig& cli = config.defaults;
+   const char* configfile = NULL;
    const char* logfile = "/dev/null";
+   size_t workers = 2 * max(1u, thread::hardware_concurrency());
    int option = 0;
    bool daemon = false;
    bool verbose = false;
+   bool async = false;
 
-   // catch signals to close established Snap7 client connection ...
-   signal(SIGABRT, &signal_handler);
-   signal(SIGTERM, &signal_handler);
-   signal(SIGINT, &signal_handler);
+   // signals are read from a signalfd by the scheduler, block them before any thread is started
+   sigset_t signals;
+   sigemptyset(&signals);
+   sigaddset(&signals, SIGTERM);
+   sigaddset(&signals, SIGINT);
+   sigaddset(&signals, SIGHUP);
+   pthread_sigmask(SIG_BLOCK, &signals, NULL);
 
    if (argc <= 1) {
       usage();
       return EXIT_FAILURE;
    }
 
-   while ((option = getopt(argc, argv, "dvi:r:s:p:u:k:t:c:e:l:")) != -1) {
+   while ((option = getopt(argc, argv, "dvaf:i:r:s:p:u:k:t:c:e:l:w:b:L:A:g:o:N:E:S:")) != -1) {
       switch (option) {
       case 'v':
          verbose = true;
@@ -141,35 +230,76 @@ int main(int argc, char *argv[]) {
       case 'd':
          daemon = true;
          break;
+      case 'a':
+         async = true;
+         break;
+      case 'f':
+         configfile = optarg;
+         break;
       case 'i':
-         ip = optarg;
+         cli.ip = optarg;
          break;
       case 'r':
-         rack = atoi(optarg);
+         cli.rack = atoi(optarg);
          break;
       case 's':
-         slot = atoi(optarg);
+         cli.slot = atoi(optarg);
          break;
       case 'p':
-         pollingRate = atoi(optarg);
+         if (!parse_duration(optarg, cli.pollingRate)) {
+            usage();
+            return EXIT_FAILURE;
+         }
          break;
       case 'k':
-         key = optarg;
+         cli.pushover.key = optarg;
          break;
       case 't':
-         token = optarg;
+         cli.pushover.token = optarg;
          break;
       case 'c':
-         retry = optarg;
+         cli.pushover.retry = optarg;
          break;
       case 'e':
-         expire = optarg;
+         cli.pushover.expire = optarg;
          break;
       case 'l':
          logfile = optarg;
          break;
       case 'u':
-         device = optarg;
+         cli.pushover.device = optarg;
+         break;
+      case 'w':
+         workers = max(1, atoi(optarg));
+         break;
+      case 'b':
+         cli.pushover.callback = optarg;
+         break;
+      case 'L':
+         config.listen = optarg;
+         break;
+      case 'A':
+         config.api = optarg;
+         break;
+      case 'N':
+         config.notify.push_back(optarg);
+         break;
+      case 'o':
+         config.outbox = optarg;
+         break;
+      case 'E':
+         config.events = optarg;
+         break;
+      case 'S':
+         config.state = optarg;
+         break;
+      case 'g':
+         if (!strcmp(optarg, "0")) {
+            config.coalesce = chrono::milliseconds::zero();
+         } else if (!parse_duration(optarg, config.coalesce)) {
+            usage();
+            return EXIT_FAILURE;
+         }
          break;
       default:
          usage();
@@ -177,84 +307,156 @@ int main(int argc, char *argv[]) {
       }
    }
 
-   // mandatory parameters available?
-   if (rack == -1 || slot == -1 || !ip || !key || !token) {
-      usage();
-      return EXIT_FAILURE;
+   // a reload applies the file to the command line again
+   const Config commandLine = config;
+   string configpath;
+   if (configfile) {
+      if (!load_config(configfile, config)) {
+         return EXIT_FAILURE;
+      }
+      if (config.plcs.empty()) {
+         tcerr() << configfile << ": no plc to watch" << endl;
+         return EXIT_FAILURE;
+      }
+      // daemonize() changes to /, a reload reads the file by its absolute path
+      char* resolved = realpath(configfile, NULL);
+      configpath = resolved ? resolved : configfile;
+      free(resolved);
+   } else {
+      // mandatory parameters available?
+      if (cli.rack == -1 || cli.slot == -1 || cli.ip.empty() || cli.pushover.key.empty() || cli.pushover.token.empty()) {
+         usage();
+         return EXIT_FAILURE;
+      }
+      config.plcs.push_back(cli);
+   }
+   char cwd[PATH_MAX];
+   if (getcwd(cwd, sizeof(cwd))) {
+      startDirectory = cwd;
    }
+   resolve_paths(config);
 
    // daemonize process and run forever
    if (daemon) {
       daemonize();
    }
 
-   if (!verbose || daemon) {
+   bool redirected = !verbose || daemon;
+   if (redirected) {
       // redirect tcout / cerr to logfile
       [[maybe_unused]] auto f_stdout = freopen(logfile, "a", stdout);
       [[maybe_unused]] auto f_stderr = freopen(logfile, "a", stderr);
    }
+   // from now on the log is written by a background thread, polling never waits for the disk
+   logging::Logger::instance().start();
 
-   tcout() << "Start state polling every " << pollingRate << " seconds" << endl;
-
-   // start state polling every 'pollingRate' seconds
-   while (1) {
-      static bool notify_connect_error = true;
-      static bool notify_connect_success = true;
-      static bool notify_run = true;
-      sleep(pollingRate);
-
-      if (!check(s7Client.ConnectTo(ip, rack, slot), "s7Client.ConnectTo()")) {
-         if(notify_connect_error) {
-            tcout() << "S7 connection failed!" << endl;
-            (void)push_emergency("Homeautomation system disconnected", "S7 connection failed", "1", retry, expire, key, token, device);
-            notify_connect_error = false;
+   // libcurl global state is not thread safe, initialize it once before the workers start
+   curl_global_init(CURL_GLOBAL_ALL);
+   {
+      // closes the kept alive connections before the global cleanup
+      Pushover pushover(config.api.empty() ? Pushover::defaultApi : config.api);
+      Outbox outbox(pushover);
+      if (!config.outbox.empty() && !outbox.open(config.outbox)) {
+         return EXIT_FAILURE;
+      }
+      EventLog history;
+      if (!config.events.empty() && !history.open(config.events)) {
+         return EXIT_FAILURE;
+      }
+      Checkpoint checkpoint;
+      if (!config.state.empty() && !checkpoint.open(config.state)) {
+         return EXIT_FAILURE;
+      }
+      ReceiptTracker receipts(pushover);
+      FanOut notifier;
+      notifier.add(unique_ptr<Notifier>(new PushoverNotifier(outbox)));
+      for (const string& spec : config.notify) {
+         unique_ptr<Notifier> backend = create_notifier(spec);
+         if (!backend) {
+            tcerr() << "Invalid notification backend '" << spec << "'" << endl;
+            return EXIT_FAILURE;
          }
-         notify_connect_success = true;
-         check(s7Client.Disconnect(), "s7Client.Disconnect()");
-         continue;
+         notifier.add(move(backend));
       }
-      // connection established
-      if(notify_connect_success) {
-         tcout() << "S7 connection established!" << endl;
-         (void)push_emergency("Homeautomation system connected", "S7 connection established", "0", retry, expire, key, token, device);
-         notify_connect_success = false;
+      Coalescer coalescer(notifier, config.coalesce);
+      CallbackServer callbacks(receipts);
+      if (!config.listen.empty() && !callbacks.listen(config.listen)) {
+         return EXIT_FAILURE;
       }
-      notify_connect_error = true;
 
-      if (S7CpuStatusStop == s7Client.PlcStatus()) {
-         tcout() << "Plc state STOP." << endl;
-         string receipt = push_emergency("Homeautomation system crashed", "Acknowledge to requst STARTUP", "2", retry, expire, key, token, device);
-         bool acknowledged = false;
+      // no need for more threads than plcs
+      ThreadPool pool(min(workers, config.plcs.size()));
+      tcout() << "Poll " << config.plcs.size() << " plc(s) with " << pool.size() << " worker(s)" << endl;
 
-         if(receipt.empty()) {
-            tcout() << "Error during pushing... retry" << endl;
-            continue;
+      unique_ptr<AsyncPoller> engine(async ? new AsyncPoller() : nullptr);
+      Scheduler scheduler(pool, engine.get());
+      scheduler.on_report([&pushover, &notifier] {
+         Pushover::Budget budget = pushover.budget();
+         char reset[32] = "";
+         strftime(reset, sizeof(reset), "%Y-%m-%d %H:%M", localtime(&budget.reset));
+         tcout() << "Pushover budget: " << (budget.remaining < 0 ? string("unknown") : to_string(budget.remaining)
+               + " of " + to_string(budget.limit) + " messages left until " + reset) << ", " << budget.waiting
+               << " waiting, " << budget.dropped << " dropped" << endl;
+         for (const FanOut::Stats& s : notifier.collect_stats()) {
+            tcout() << "Notifier " << s.name << ": " << s.sent << " sent, " << s.failed << " failed, " << s.dropped
+                  << " dropped, latency avg " << chrono::duration_cast<chrono::milliseconds>(s.average).count()
+                  << " ms, max " << chrono::duration_cast<chrono::milliseconds>(s.max).count() << " ms" << endl;
          }
-
-         do {
-            sleep(5); // respect API and wait 5 seconds
-            tcout() << "Acknowledged?" << endl;
-            acknowledged = poll_receipt(receipt, token);
-         } while (!acknowledged && (S7CpuStatusStop == s7Client.PlcStatus()));
-
-         if (acknowledged) {
-            tcout() << "Acknowledged! Request RUN and re-arm watchdog." << endl;
-            check(s7Client.PlcHotStart(), "s7Client.PlcColdStart()");
-         } else {
-            tcout() << "Left STOP. Cancel emergency and re-arm watchdog!" << endl;
-            cancel_emergency(receipt, token);
-         }
-         notify_run = true;
-      } else if(S7CpuStatusRun == s7Client.PlcStatus()) {
-         if(notify_run) {
-            tcout() << "Plc state RUN." << endl;
-            (void)push_emergency("Homeautomation system alive", "PLC state RUN", "-1", retry, expire, key, token, device);
-            notify_run = false;
+      });
+      auto start = [&](const PlcConfig& plc) {
+         watchdogs.emplace_back(new Watchdog(plc, notifier, outbox, receipts, coalescer, history, checkpoint));
+         scheduler.add(watchdogs.back().get());
+         tcout() << (plc.name.empty() ? plc.ip : plc.name) << ": Start state polling every " << plc.pollingRate.count()
+               << " ms" << endl;
+      };
+      scheduler.on_signal(signals, [&](int s) {
+         if (s == SIGHUP) {
+            // logrotate moved the file or the configuration changed, the sessions stay open
+            if (redirected && !logging::Logger::reopen(logfile)) {
+               tcerr() << "Unable to reopen " << logfile << ": " << strerror(errno) << endl;
+            }
+            tcout() << "SIG " << s << " (" << strsignal(s) << ") received, log reopened" << endl;
+            if (configfile) {
+               reload(configpath.c_str(), commandLine, config, scheduler, start);
+            }
+            return true;
          }
+         tcout() << "SIG " << s << " (" << strsignal(s) << ") received, shutting down" << endl;
+         return false;
+      });
+      for (const PlcConfig& plc : config.plcs) {
+         start(plc);
       }
 
-      check(s7Client.Disconnect(), "s7Client.Disconnect()");
+      // resend what the last run left and follow its open emergencies, those restored from the state file once
+      outbox.replay([](const string& source, const string& receipt, const string&) {
+         for (auto& watchdog : watchdogs) {
+            if (watchdog->config().name == source) {
+               watchdog->adopt(receipt);
+               return true;
+            }
+         }
+         return false;
+      });
+
+      // poll every plc every 'pollingRate' milliseconds until SIGTERM / SIGINT
+      scheduler.run();
+
+      // the cycles have finished: hand over the open emergencies, close the sessions and deliver what is queued
+      chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + shutdownTimeout;
+      for (auto& watchdog : watchdogs) {
+         watchdog->shutdown(!config.outbox.empty() || !config.state.empty());
+      }
+      coalescer.stop();
+      size_t lost = notifier.drain(deadline);
+      size_t pending = outbox.drain(deadline);
+      if (lost || pending) {
+         tcerr() << "Shutdown: " << lost << " notification(s) not handed to a backend, " << pending
+               << " not delivered" << (config.outbox.empty() || !pending ? "" : ", kept in the outbox") << endl;
+      }
    }
 
+   curl_global_cleanup();
+   tcout() << "Shutdown complete" << endl;
    return EXIT_SUCCESS;
 }
@@ -0,0 +1,294 @@
+/*
+ * scheduler.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include "scheduler.h"
+#include "log.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+// interval of the worker statistics in the log
+static const minutes reportRate(10);
+
+Scheduler::Scheduler(ThreadPool& threadPool, AsyncPoller* asyncPoller) :
+      pool(threadPool), engine(asyncPoller),
+      timerFd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+      wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+   if (timerFd < 0 || wakeFd < 0) {
+      tcerr() << "Scheduler: unable to create timerfd/eventfd" << endl;
+      exit(EXIT_FAILURE);
+   }
+}
+
+Scheduler::~Scheduler() {
+   close(timerFd);
+   close(wakeFd);
+   if (signalFd >= 0) {
+      close(signalFd);
+   }
+}
+
+void Scheduler::on_signal(const sigset_t& signals, function<bool(int)> handler) {
+   signalFd = signalfd(signalFd, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+   if (signalFd < 0) {
+      tcerr() << "Scheduler: unable to create signalfd" << endl;
+      exit(EXIT_FAILURE);
+   }
+   signalHandler = move(handler);
+}
+
+void Scheduler::add(Watchdog* watchdog) {
+   pending.push_back(watchdog);
+   watchdog->on_acknowledge([this, watchdog] {
+      expedite(watchdog);
+   });
+}
+
+void Scheduler::expedite(Watchdog* watchdog) {
+   {
+      lock_guard<std::mutex> lock(mutex);
+      urgent.insert(watchdog);
+   }
+   uint64_t one = 1;
+   [[maybe_unused]] auto n = write(wakeFd, &one, sizeof(one));
+}
+
+void Scheduler::finished(Entry entry) {
+   clock::time_point now = clock::now();
+   clock::duration interval = entry.watchdog->interval();
+   entry.due += interval;
+   unsigned long skipped = 0;
+   if (entry.due <= now) {
+      // overrun, skip the deadlines already passed but stay in phase
+      skipped = (now - entry.due) / interval + 1;
+      entry.due += interval * skipped;
+   }
+   {
+      lock_guard<std::mutex> lock(mutex);
+      done.push_back(entry);
+      if (skipped) {
+         missed[entry.watchdog] += skipped;
+      }
+   }
+   uint64_t one = 1;
+   [[maybe_unused]] auto n = write(wakeFd, &one, sizeof(one));
+}
+
+/** @brief Start the cycle of a due watchdog */
+void Scheduler::dispatch(const Entry& entry) {
+   Watchdog* watchdog = entry.watchdog;
+   ++running;
+   if (engine && watchdog->established()) {
+      reading[watchdog] = entry;
+      if (engine->submit(watchdog->connection(), watchdog)) {
+         return;
+      }
+      reading.erase(watchdog);
+   }
+   pool.submit([this, entry] {
+      entry.watchdog->poll();
+      finished(entry);
+   });
+}
+
+/** @brief Finish the cycles whose cpu state has been read by the engine */
+void Scheduler::completed() {
+   completions.clear();
+   engine->collect(completions);
+   for (const AsyncPoller::Completion& c : completions) {
+      Watchdog* watchdog = static_cast<Watchdog*>(c.context);
+      Entry entry = reading[watchdog];
+      reading.erase(watchdog);
+      ++asyncReads;
+      asyncLatency += c.latency;
+
+      if (c.result == 0 && watchdog->quiet(c.health)) {
+         finished(entry);
+      } else if (c.result == 0) {
+         PlcHealth health = c.health;
+         pool.submit([this, entry, health] {
+            entry.watchdog->evaluate(health);
+            finished(entry);
+         });
+      } else {
+         // session dropped by the engine, reconnect on a worker
+         pool.submit([this, entry] {
+            entry.watchdog->poll();
+            finished(entry);
+         });
+      }
+   }
+}
+
+/** @brief Arm the timerfd on an absolute deadline of the monotonic clock
+ *
+ * steady_clock is CLOCK_MONOTONIC on linux, so its time points can be used as is.
+ */
+void Scheduler::arm(clock::time_point deadline) {
+   nanoseconds ns = duration_cast<nanoseconds>(deadline.time_since_epoch());
+   struct itimerspec spec = {};
+   spec.it_value.tv_sec = duration_cast<seconds>(ns).count();
+   spec.it_value.tv_nsec = (ns % seconds(1)).count();
+   if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+      spec.it_value.tv_nsec = 1; // zero would disarm the timer
+   }
+   timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+void Scheduler::report() {
+   vector<ThreadPool::WorkerStats> stats = pool.collect_stats();
+   for (size_t i = 0; i < stats.size(); ++i) {
+      tcout() << "Worker " << i << ": utilisation " << fixed << setprecision(1) << stats[i].utilisation * 100
+            << "%, " << stats[i].tasks << " polls, " << stats[i].steals << " steals" << endl;
+   }
+
+   if (engine) {
+      tcout() << "Async state reads: " << asyncReads << ", average latency "
+            << (asyncReads ? duration_cast<microseconds>(asyncLatency).count() / asyncReads : 0) << " us" << endl;
+      asyncReads = 0;
+      asyncLatency = clock::duration::zero();
+   }
+
+   map<const Watchdog*, unsigned long> overruns;
+   {
+      lock_guard<std::mutex> lock(mutex);
+      overruns.swap(missed);
+   }
+   for (const auto& m : overruns) {
+      const PlcConfig& plc = m.first->config();
+      tcout() << (plc.name.empty() ? plc.ip : plc.name) << ": " << m.second << " missed deadline(s)" << endl;
+   }
+   if (extra) {
+      extra();
+   }
+}
+
+void Scheduler::remove(Watchdog* watchdog) {
+   rebuild([watchdog](Entry& entry) {
+      return entry.watchdog != watchdog;
+   });
+   pending.erase(std::remove(pending.begin(), pending.end(), watchdog), pending.end());
+   lock_guard<std::mutex> lock(mutex);
+   urgent.erase(watchdog);
+   missed.erase(watchdog);
+}
+
+void Scheduler::reschedule(Watchdog* watchdog) {
+   clock::time_point latest = clock::now() + watchdog->interval();
+   rebuild([watchdog, latest](Entry& entry) {
+      if (entry.watchdog == watchdog) {
+         entry.due = min(entry.due, latest);
+      }
+      return true;
+   });
+}
+
+/** @brief Rebuild the queue, keep(entry) may change the entry and returns false to drop it */
+void Scheduler::rebuild(const function<bool(Entry&)>& keep) {
+   vector<Entry> entries;
+   for (; !queue.empty(); queue.pop()) {
+      Entry entry = queue.top();
+      if (keep(entry)) {
+         entries.push_back(entry);
+      }
+   }
+   for (const Entry& entry : entries) {
+      queue.push(entry);
+   }
+}
+
+void Scheduler::run() {
+   clock::time_point now = clock::now();
+   clock::time_point nextReport = now + reportRate;
+
+   struct pollfd fds[4] = { { timerFd, POLLIN, 0 }, { wakeFd, POLLIN, 0 }, { engine ? engine->fd() : -1, POLLIN, 0 },
+         { signalFd, POLLIN, 0 } };
+   vector<int> signals;       // received, handled once no cycle is running
+   for (;;) {
+      if (engine) {
+         completed();
+      }
+      now = clock::now();
+      {
+         lock_guard<std::mutex> lock(mutex);
+         running -= done.size();
+         for (Entry entry : done) {
+            if (urgent.erase(entry.watchdog)) {
+               entry.due = now;
+            }
+            queue.push(entry);
+         }
+         done.clear();
+         if (!urgent.empty()) {
+            // rare, rebuild the queue with the urgent watchdogs due now, the others are still running
+            rebuild([this, now](Entry& entry) {
+               if (urgent.erase(entry.watchdog)) {
+                  entry.due = min(entry.due, now);
+               }
+               return true;
+            });
+         }
+      }
+
+      if (!pending.empty()) {
+         // stagger the first cycles, so a large fleet does not connect all at once
+         for (size_t i = 0; i < pending.size(); ++i) {
+            clock::duration interval = pending[i]->interval();
+            queue.push(Entry { now + interval * (i + 1) / pending.size(), pending[i] });
+         }
+         pending.clear();
+      }
+
+      if (!signals.empty()) {
+         if (running) {
+            // no new cycles, wait for the running ones
+            poll(fds + 1, 2, -1);
+            uint64_t count;
+            [[maybe_unused]] auto n = read(wakeFd, &count, sizeof(count));
+            continue;
+         }
+         bool stop = false;
+         for (int s : signals) {
+            stop = !signalHandler(s) || stop;
+         }
+         signals.clear();
+         if (stop) {
+            break;
+         }
+         continue;
+      }
+
+      while (!queue.empty() && queue.top().due <= now) {
+         Entry entry = queue.top();
+         queue.pop();
+         dispatch(entry);
+      }
+      if (now >= nextReport) {
+         nextReport += reportRate;
+         report();
+      }
+
+      arm(queue.empty() ? nextReport : min(queue.top().due, nextReport));
+      if (poll(fds, 4, -1) < 0) {
+         continue; // EINTR
+      }
+      uint64_t count;
+      [[maybe_unused]] auto n = read(timerFd, &count, sizeof(count));
+      n = read(wakeFd, &count, sizeof(count));
+      struct signalfd_siginfo info;
+      while (signalFd >= 0 && read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+         signals.push_back(info.ssi_signo);
+      }
+   }
+}
@@ -0,0 +1,119 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef MAIN_SCHEDULER_H_
+#define MAIN_SCHEDULER_H_
+
+#include <signal.h>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "asyncpoller.h"
+#include "threadpool.h"
+#include "watchdog.h"
+
+/** @brief Runs the poll cycles of all watchdogs from a single deadline queue
+ *
+ * Deadlines are absolute points on the monotonic clock, the next one is armed on a timerfd.
+ * A cycle is due one interval after the previous deadline, not after the previous cycle
+ * finished, so the period does not drift by the execution time of a cycle. Deadlines passed
+ * while a cycle was still running are counted as missed and skipped.
+ *
+ * Due cycles are handed to a ThreadPool as tasks. A watchdog is queued again once its
+ * cycle has finished, so it is never polled by two workers at the same time.
+ *
+ * With an AsyncPoller the cpu state of established sessions is read asynchronously from the
+ * scheduler thread. Only cycles with something to do (connect, notifications, open emergency)
+ * go to the pool.
+ */
+class Scheduler {
+public:
+   typedef std::chrono::steady_clock clock;
+
+   /** @param pool workers executing the poll cycles
+    * @param engine optional asynchronous state reader
+    */
+   explicit Scheduler(ThreadPool& pool, AsyncPoller* engine = nullptr);
+   ~Scheduler();
+
+   Scheduler(const Scheduler&) = delete;
+   Scheduler& operator=(const Scheduler&) = delete;
+
+   /** @brief Add a watchdog, the first cycles are spread over the polling interval
+    *
+    * Call before run() or from the signal handler.
+    * @param watchdog watchdog to poll, must outlive the scheduler
+    */
+   void add(Watchdog* watchdog);
+   /** @brief Stop polling a watchdog, from the signal handler only */
+   void remove(Watchdog* watchdog);
+   /** @brief Run the next cycle within the current interval of the watchdog, e.g. after it was shortened
+    *
+    * From the signal handler only.
+    */
+   void reschedule(Watchdog* watchdog);
+   /** @brief Run the next cycle of a watchdog at once, from any thread
+    *
+    * A cycle already running is followed by another one right away.
+    */
+   void expedite(Watchdog* watchdog);
+   /** @brief Add lines to the periodic report, e.g. the metrics of a shared service */
+   void on_report(std::function<void()> reporter) { extra = std::move(reporter); }
+   /** @brief Take signals from a signalfd in the loop of run() instead of a signal handler
+    *
+    * No new cycles are started once a signal arrived, the handler is called when the running ones have
+    * finished. It may change the configuration of the watchdogs and add or remove some.
+    * @param signals blocked in all threads by the caller
+    * @param handler called on the scheduler thread, returns false to stop
+    */
+   void on_signal(const sigset_t& signals, std::function<bool(int)> handler);
+   /** @brief Poll the watchdogs when due
+    *
+    * Returns once the signal handler asked to stop and the running cycles have finished.
+    */
+   void run();
+
+private:
+   struct Entry {
+      clock::time_point due;
+      Watchdog* watchdog;
+      bool operator>(const Entry& other) const { return due > other.due; }
+   };
+
+   void dispatch(const Entry& entry);
+   void completed();
+   void finished(Entry entry);
+   void arm(clock::time_point deadline);
+   void report();
+   void rebuild(const std::function<bool(Entry&)>& keep);
+
+   ThreadPool& pool;
+   AsyncPoller* engine;
+   std::unordered_map<const Watchdog*, Entry> reading;  ///< cycles waiting for the engine
+   std::vector<AsyncPoller::Completion> completions;
+   unsigned long asyncReads = 0;
+   clock::duration asyncLatency = clock::duration::zero();
+   int timerFd;
+   int wakeFd;               ///< eventfd signalled by finished cycles
+   int signalFd = -1;
+   std::function<bool(int)> signalHandler;
+   size_t running = 0;       ///< cycles dispatched and not requeued yet, scheduler thread only
+   std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+   std::vector<Watchdog*> pending;
+   std::mutex mutex;
+   std::vector<Entry> done;  ///< finished cycles, requeued by run()
+   std::unordered_set<const Watchdog*> urgent;  ///< watchdogs to run at once
+   std::map<const Watchdog*, unsigned long> missed;  ///< missed deadlines since the last report
+   std::function<void()> extra;
+};
+
+#endif /* MAIN_SCHEDULER_H_ */
@@ -0,0 +1,337 @@
+/*
+ * watchdog.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <iomanip>
+#include "watchdog.h"
+#include "log.hpp"
+
+using namespace std;
+
+// respect API and poll an open receipt every 5 seconds
+static const chrono::seconds receiptPollingRate(5);
+// with a callback URL polling is a fallback only
+static const chrono::seconds fallbackPollingRate(60);
+
+/** @brief Polling cadence of an open receipt */
+static chrono::seconds receipt_cadence(const PushoverConfig& p) {
+   return p.callback.empty() ? receiptPollingRate : fallbackPollingRate;
+}
+
+Watchdog::Watchdog(const PlcConfig& config, Notifier& notifier, Outbox& outbox, ReceiptTracker& receipts,
+      Coalescer& coalescer, EventLog& history, Checkpoint& checkpoint) :
+      cfg(config), notifier(notifier), outbox(outbox), receipts(receipts), coalescer(coalescer), history(history),
+      historyId(history.plc(config.name.empty() ? config.ip : config.name)), checkpoint(checkpoint),
+      checkpointSlot(checkpoint.attach(config.name.empty() ? config.ip : config.name, saved)),
+      plc(config.ip, config.rack, config.slot), index(watchlist) {
+   for (const TagConfig& tag : cfg.tags) {
+      index.add(tag.name, tag.address);
+   }
+   // resume where the last run stopped: nothing announced twice, the open emergency followed up
+   notifyConnectError = saved.notifyConnectError;
+   notifyConnectSuccess = saved.notifyConnectSuccess;
+   notifyRun = saved.notifyRun;
+   recordedStatus = saved.status;
+   // -1 if nothing was recorded, last only holds RUN, STOP or unknown
+   if (saved.status != -1 && S7CpuStatusUnknown != saved.status) {
+      last.status = saved.status;
+   }
+   last.previous = saved.previous;
+   last.event = saved.event;
+   last.eventTime = saved.eventTime;
+   if (!saved.receipt.empty()) {
+      tcout() << (cfg.name.empty() ? cfg.ip : cfg.name) << ": Follow up the open emergency of the last run" << endl;
+      adopt(saved.receipt);
+   }
+}
+
+Watchdog::clock::duration Watchdog::interval() const {
+   if (!receipt.empty() || pushing) {
+      return min<clock::duration>(cfg.pollingRate, receiptPollingRate);
+   }
+   return cfg.pollingRate;
+}
+
+string Watchdog::text(const char* message) const {
+   return cfg.name.empty() ? string(message) : cfg.name + ": " + message;
+}
+
+/** @brief Send a notification, those without result go through the coalescer */
+void Watchdog::push(const char* title, const char* message, const char* priority, PushoverCallback done) {
+   const PushoverConfig& p = cfg.pushover;
+   history.push(historyId, atoi(priority), title);
+   if (!done) {
+      coalescer.push(cfg.name, title, message, priority, p.retry.c_str(), p.expire.c_str(), p.key.c_str(),
+            p.token.c_str(), p.device.empty() ? NULL : p.device.c_str());
+      return;
+   }
+   notifier.send(Notification { cfg.name, title, text(message), priority, p.retry, p.expire, p.key, p.token, p.device,
+         strcmp(priority, "2") ? string() : p.callback }, move(done));
+}
+
+/** @brief Callback queueing the result as event of this watchdog, may be created on any thread
+ *
+ * The receipt the request refers to is kept with the result, so a late answer about a closed
+ * emergency is recognized.
+ */
+PushoverCallback Watchdog::event(const string& current) {
+   ++outstanding;
+   return [this, current](const PushoverResult& result) {
+      PushoverResult e = result;
+      if (e.request != PushoverResult::Push) {
+         e.receipt = current;
+      }
+      bool wake = e.acknowledged && waker;
+      events.push(move(e));
+      if (wake) {
+         waker();
+      }
+   };
+}
+
+/** @brief Callback of the STOP emergency
+ *
+ * The receipt is tracked right away on the dispatcher thread, an acknowledgement may arrive on
+ * the callback URL before the next cycle. Its event is queued behind the one of the push. The
+ * parameters are taken now, a reload may change the configuration meanwhile.
+ */
+PushoverCallback Watchdog::emergency() {
+   PushoverCallback pushed = event(string());
+   const PushoverConfig& p = cfg.pushover;
+   string token = p.token;
+   clock::duration cadence = receipt_cadence(p);
+   clock::duration expire = chrono::seconds(strtol(p.expire.c_str(), NULL, 10));
+   return [this, pushed, token, cadence, expire](const PushoverResult& result) {
+      pushed(result);
+      if (!result.receipt.empty() && !stopped) {
+         track(result.receipt, token, cadence, expire);
+      }
+   };
+}
+
+void Watchdog::track(const string& current, const string& token, clock::duration cadence, clock::duration expire) {
+   receipts.track(current, token, cadence, expire, event(current));
+}
+
+void Watchdog::adopt(const string& open) {
+   if (open == receipt) {
+      return;  // restored from the state file and replayed by the outbox
+   }
+   const PushoverConfig& p = cfg.pushover;
+   receipt = open;
+   track(open, p.token, receipt_cadence(p), chrono::seconds(strtol(p.expire.c_str(), NULL, 10)));
+}
+
+void Watchdog::reconfigure(const PlcConfig& config) {
+   bool tags = config.tags != cfg.tags;
+   cfg = config;
+   if (tags) {
+      index.clear();
+      for (const TagConfig& tag : cfg.tags) {
+         index.add(tag.name, tag.address);
+      }
+   }
+}
+
+void Watchdog::shutdown(bool persist) {
+   const string& id = cfg.name.empty() ? cfg.ip : cfg.name;
+
+   stopped = true;
+   handle_events();
+   if (!receipt.empty()) {
+      if (persist) {
+         tcout() << id << ": Emergency stays open, followed up after the restart" << endl;
+         receipts.release(receipt);
+         // saved with the receipt, the next run follows it up
+         save();
+         receipt.clear();
+      } else {
+         tcout() << id << ": Cancel open emergency, nobody follows it up" << endl;
+         receipts.cancel(receipt);
+         outbox.closed(receipt);
+         history.receipt(historyId, ReceiptCancelled, receipt, 0);
+         receipt.clear();
+         save();
+      }
+   }
+   plc.disconnect();
+}
+
+void Watchdog::forget() {
+   checkpoint.release(checkpointSlot);
+   checkpointSlot = Checkpoint::npos;
+}
+
+/** @brief Write the state to the state file if it changed, at the end of each step of a cycle */
+void Watchdog::save() {
+   WatchdogState state;
+   state.notifyConnectError = notifyConnectError;
+   state.notifyConnectSuccess = notifyConnectSuccess;
+   state.notifyRun = notifyRun;
+   state.receipt = receipt;
+   state.status = recordedStatus;
+   state.previous = last.previous;
+   state.event = last.event;
+   state.eventTime = last.eventTime;
+   if (state != saved) {
+      checkpoint.save(checkpointSlot, state);
+      saved = move(state);
+   }
+}
+
+/** @brief Apply the results of the completed requests */
+void Watchdog::handle_events() {
+   const string& id = cfg.name.empty() ? cfg.ip : cfg.name;
+
+   PushoverResult result;
+   while (events.pop(result)) {
+      --outstanding;
+      if (PushoverResult::Push == result.request) {
+         pushing = false;
+         if (result.receipt.empty()) {
+            tcout() << id << ": Error during pushing... retry" << endl;
+            history.receipt(historyId, ReceiptFailed, string(), result.http);
+         } else {
+            receipt = result.receipt;
+            history.receipt(historyId, ReceiptIssued, receipt, result.http);
+         }
+      } else if (PushoverResult::Poll == result.request && result.receipt == receipt) {
+         if (result.acknowledged && !acknowledged) {
+            history.receipt(historyId, ReceiptAcknowledged, receipt, result.http);
+         } else if (result.expired && !expired) {
+            history.receipt(historyId, ReceiptExpired, receipt, result.http);
+         }
+         acknowledged = result.acknowledged;
+         expired = result.expired;
+      }
+   }
+}
+
+void Watchdog::poll() {
+   if (connect()) {
+      PlcHealth health;
+      plc.read_health(health);
+      evaluate(health);
+   }
+}
+
+bool Watchdog::quiet(const PlcHealth& health) const {
+   return receipt.empty() && !outstanding && watchlist.empty() && health.same_transition(last)
+         && (S7CpuStatusUnknown == health.status || (S7CpuStatusRun == health.status && !notifyRun));
+}
+
+/** @brief Establish the session if needed and announce connection changes
+ * @return true if the session is usable
+ */
+bool Watchdog::connect() {
+   const string& id = cfg.name.empty() ? cfg.ip : cfg.name;
+
+   // keep the session open, connect() only talks to the PLC if the link is down
+   bool connected = plc.connect();
+   if (plc.attempts() != attempts) {
+      attempts = plc.attempts();
+      history.connect(historyId, plc.connect_result(), connected
+            ? chrono::duration_cast<chrono::microseconds>(plc.connect_latency()).count() : 0);
+   }
+   if (!connected) {
+      if (notifyConnectError) {
+         tcout() << id << ": S7 connection failed!" << endl;
+         push("Homeautomation system disconnected", "S7 connection failed", "1");
+         notifyConnectError = false;
+      }
+      notifyConnectSuccess = true;
+      save();
+      return false;
+   }
+   // connection established
+   if (notifyConnectSuccess) {
+      tcout() << id << ": S7 connection established!" << endl;
+      push("Homeautomation system connected", "S7 connection established", "0");
+      notifyConnectSuccess = false;
+   }
+   notifyConnectError = true;
+   save();
+   return true;
+}
+
+void Watchdog::evaluate(const PlcHealth& health) {
+   const string& id = cfg.name.empty() ? cfg.ip : cfg.name;
+   int status = health.status;
+
+   // same state, but the cpu went through another mode since the last poll
+   if (S7CpuStatusUnknown != status && status == last.status && !health.same_transition(last)) {
+      tcout() << id << ": Mode transition since last poll, event 0x" << hex << setw(4) << setfill('0')
+            << health.event << dec << setfill(' ') << ", previous mode " << health.previous << endl;
+   }
+   if (status != recordedStatus || (S7CpuStatusUnknown != status && !health.same_transition(last))) {
+      history.status(historyId, status, health.previous, health.event);
+      recordedStatus = status;
+   }
+   if (S7CpuStatusUnknown != status) {
+      last = health;
+   }
+   if (!watchlist.empty() && plc.connected() && watchlist.read(plc) && index.update()) {
+      for (size_t i = 0; i < index.size(); ++i) {
+         if (index[i].changed) {
+            tcout() << id << ": " << index[i].name << " = " << format_tag(index[i]) << endl;
+         }
+      }
+   }
+
+   handle_events();
+   if (!receipt.empty()) {
+      follow_emergency(status);
+   } else if (pushing) {
+      // emergency on its way, the receipt is picked up by one of the next cycles
+   } else if (S7CpuStatusStop == status) {
+      // once per emergency, not part of the snapshot
+      int modeSwitch = plc.mode_switch();
+      tcout() << id << ": Plc state STOP." << (modeSwitch == 3 ? " Mode switch in STOP, HotStart not possible." : "")
+            << endl;
+      pushing = true;
+      push("Homeautomation system crashed", "Acknowledge to requst STARTUP", "2", emergency());
+   } else if (S7CpuStatusRun == status) {
+      if (notifyRun) {
+         tcout() << id << ": Plc state RUN." << endl;
+         push("Homeautomation system alive", "PLC state RUN", "-1");
+         notifyRun = false;
+      }
+   }
+   save();
+}
+
+/** @brief Follow up the open STOP emergency
+ *
+ * The receipt tracker polls the receipt every receiptPollingRate (fallbackPollingRate if the
+ * acknowledgement is posted to the callback URL), the cpu state is checked on every cycle.
+ * @param status current cpu state
+ */
+void Watchdog::follow_emergency(int status) {
+   const string& id = cfg.name.empty() ? cfg.ip : cfg.name;
+
+   if (acknowledged) {
+      tcout() << id << ": Acknowledged! Request RUN and re-arm watchdog." << endl;
+      int result = plc.client().PlcHotStart();
+      history.hot_start(historyId, result);
+      plc.check(result, "s7Client.PlcHotStart()");
+   } else if (S7CpuStatusStop != status) {
+      tcout() << id << ": Left STOP. Cancel emergency and re-arm watchdog!" << endl;
+      receipts.cancel(receipt);
+      history.receipt(historyId, ReceiptCancelled, receipt, 0);
+   } else if (expired) {
+      // still in STOP, the next cycle sends a new emergency
+      tcout() << id << ": Emergency expired without acknowledgement!" << endl;
+   } else {
+      return;
+   }
+   outbox.closed(receipt);
+   receipt.clear();
+   acknowledged = false;
+   expired = false;
+   notifyRun = true;
+}
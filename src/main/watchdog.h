@@ -0,0 +1,128 @@
+/*
+ * watchdog.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef MAIN_WATCHDOG_H_
+#define MAIN_WATCHDOG_H_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include "checkpoint.h"
+#include "coalescer.h"
+#include "config.h"
+#include "eventlog.h"
+#include "mpscqueue.h"
+#include "notifier.h"
+#include "outbox.h"
+#include "receipts.h"
+#include "s7connection.h"
+#include "tag.h"
+#include "watchlist.h"
+
+/** @brief Watches the state of a single plc
+ *
+ * Holds the S7 session and the notification state of one plc. Each call of poll() runs
+ * one cycle and never waits; notifications are sent asynchronously, their results are
+ * picked up and an open emergency is followed up by the next cycles.
+ */
+class Watchdog {
+public:
+   typedef std::chrono::steady_clock clock;
+
+   /** @param notifier delivers the emergencies of all watchdogs
+    * @param outbox journal of the open receipts
+    * @param receipts tracker following the emergencies of all watchdogs
+    * @param coalescer merges the other notifications of all watchdogs
+    * @param history event log of all watchdogs
+    * @param checkpoint state file of all watchdogs, the state of the last run is restored from it
+    */
+   Watchdog(const PlcConfig& config, Notifier& notifier, Outbox& outbox, ReceiptTracker& receipts,
+         Coalescer& coalescer, EventLog& history, Checkpoint& checkpoint);
+
+   /** @brief Run one poll cycle */
+   void poll();
+   /** @brief Run the part of a cycle following the health query
+    *
+    * All decisions of the cycle are based on this single snapshot.
+    * @param health snapshot read by the caller, e.g. via AsyncPoller
+    */
+   void evaluate(const PlcHealth& health);
+   /** @brief Session up and announced, the cpu state may be read by the caller */
+   bool established() const { return plc.connected() && !notifyConnectSuccess; }
+   /** @brief Check whether evaluate(health) has nothing to do
+    *
+    * True for the steady state, i.e. RUN already announced, no emergency open, no new mode transition
+    * and no tags to read.
+    */
+   bool quiet(const PlcHealth& health) const;
+   /** @brief Delay until the next cycle is due */
+   clock::duration interval() const;
+
+   /** @brief Follow the open emergency of the last run, before the first cycle, once per receipt */
+   void adopt(const std::string& receipt);
+   /** @brief Apply a changed configuration between two cycles, the session and the notification state are kept
+    * @param config same plc, i.e. same address, rack and slot
+    */
+   void reconfigure(const PlcConfig& config);
+   /** @brief Stop watching after the last cycle, closes the session
+    * @param persist leave the open emergency to the next run (kept by the outbox journal or the state file),
+    * cancel it otherwise
+    */
+   void shutdown(bool persist);
+   /** @brief Removed from the configuration, nothing is kept for the next run */
+   void forget();
+   /** @brief Called from any thread once the open emergency is acknowledged, e.g. to run a cycle at once */
+   void on_acknowledge(std::function<void()> wake) { waker = std::move(wake); }
+
+   const PlcConfig& config() const { return cfg; }
+   S7Connection& connection() { return plc; }
+   /** @brief Named tags and their values of the last cycle */
+   const TagIndex& tags() const { return index; }
+
+private:
+   std::string text(const char* message) const;
+   void push(const char* title, const char* message, const char* priority, PushoverCallback done = nullptr);
+   PushoverCallback event(const std::string& current);
+   PushoverCallback emergency();
+   void track(const std::string& current, const std::string& token, clock::duration cadence,
+         clock::duration expire);
+   void handle_events();
+   bool connect();
+   void follow_emergency(int status);
+   void save();
+
+   PlcConfig cfg;
+   Notifier& notifier;
+   Outbox& outbox;
+   ReceiptTracker& receipts;
+   Coalescer& coalescer;
+   EventLog& history;
+   uint16_t historyId;   ///< id of the plc in the event log
+   Checkpoint& checkpoint;
+   WatchdogState saved;  ///< state in the state file
+   size_t checkpointSlot;
+   S7Connection plc;
+   Watchlist watchlist;
+   TagIndex index;
+   bool notifyConnectError = true;
+   bool notifyConnectSuccess = true;
+   bool notifyRun = true;
+   PlcHealth last;       ///< last valid health snapshot
+   int recordedStatus = -1;        ///< cpu status of the last status event
+   unsigned long attempts = 0;     ///< connects attempted up to the last connect event
+   std::string receipt;  ///< receipt of the open STOP emergency
+   bool pushing = false;       ///< STOP emergency on its way to pushover.net
+   bool acknowledged = false;  ///< open emergency acknowledged
+   bool expired = false;       ///< open emergency expired without acknowledgement
+   std::atomic<int> outstanding { 0 }; ///< requests whose result has not been handled yet
+   std::atomic<bool> stopped { false };  ///< shut down, a receipt arriving now is left to the next run
+   std::function<void()> waker;
+   MpscQueue<PushoverResult> events;  ///< results of the requests, filled by the pushover dispatcher and the receipt tracker
+};
+
+#endif /* MAIN_WATCHDOG_H_ */
@@ -0,0 +1,90 @@
+/*
+ * asyncpoller.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "asyncpoller.h"
+#include "log.hpp"
+
+using namespace std;
+
+AsyncPoller::AsyncPoller() :
+      eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+   if (eventFd < 0) {
+      tcerr() << "AsyncPoller: unable to create eventfd" << endl;
+      exit(EXIT_FAILURE);
+   }
+}
+
+AsyncPoller::~AsyncPoller() {
+   // wait for the running jobs, their callbacks refer to this object
+   for (auto& request : requests) {
+      request.second->connection->client().WaitAsCompletion(1000);
+      request.second->connection->client().SetAsCallback(NULL, NULL);
+   }
+   close(eventFd);
+}
+
+/** @brief Called by the snap7 job thread of the client, just queue the request */
+void S7API AsyncPoller::completion(void* usrPtr, int, int opResult) {
+   Request* request = static_cast<Request*>(usrPtr);
+   AsyncPoller* poller = request->poller;
+   request->result = opResult;
+   {
+      lock_guard<std::mutex> lock(poller->mutex);
+      poller->finished.push_back(request);
+   }
+   uint64_t one = 1;
+   [[maybe_unused]] auto n = write(poller->eventFd, &one, sizeof(one));
+}
+
+bool AsyncPoller::submit(S7Connection& connection, void* context) {
+   unique_ptr<Request>& request = requests[&connection];
+   if (!request) {
+      request.reset(new Request());
+      request->poller = this;
+      request->connection = &connection;
+      connection.client().SetAsCallback(&AsyncPoller::completion, request.get());
+   }
+   request->context = context;
+   request->size = sizeof(request->szl);
+   request->start = clock::now();
+
+   ++inFlight;
+   int result = connection.client().AsReadSZL(SzlCpuStatus, 0, reinterpret_cast<PS7SZL>(&request->szl),
+         &request->size);
+   if (!connection.check(result, "s7Client.AsReadSZL()")) {
+      --inFlight;
+      return false;
+   }
+   return true;
+}
+
+size_t AsyncPoller::collect(vector<Completion>& completions) {
+   uint64_t count;
+   [[maybe_unused]] auto n = read(eventFd, &count, sizeof(count));
+
+   vector<Request*> done;
+   {
+      lock_guard<std::mutex> lock(mutex);
+      done.swap(finished);
+   }
+   for (Request* request : done) {
+      Completion c;
+      c.connection = request->connection;
+      c.context = request->context;
+      c.result = request->result;
+      c.latency = clock::now() - request->start;
+      if (request->connection->check(request->result, "s7Client.AsReadSZL()")) {
+         szl_health(request->szl, request->size, c.health);
+      }
+      completions.push_back(c);
+      --inFlight;
+   }
+   return done.size();
+}
@@ -0,0 +1,84 @@
+/*
+ * asyncpoller.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PLC_ASYNCPOLLER_H_
+#define PLC_ASYNCPOLLER_H_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "s7connection.h"
+#include "szl.h"
+
+/** @brief Reads the cpu state of many plcs through the snap7 As* API
+ *
+ * submit() starts an AsReadSZL() of the health snapshot (cpu state) and returns at once. snap7 reports the end
+ * of the job through a pfn_CliCompletion callback, which queues the request and signals fd().
+ * The owning thread calls collect() once fd() is readable, so a single thread keeps requests
+ * to any number of plcs in flight. Connecting is not asynchronous in snap7, submit() needs an
+ * established session.
+ */
+class AsyncPoller {
+public:
+   typedef std::chrono::steady_clock clock;
+
+   /** @brief A finished request */
+   struct Completion {
+      S7Connection* connection;
+      void* context;            ///< as passed to submit()
+      int result;               ///< snap7 result of the job
+      PlcHealth health;         ///< decoded answer
+      clock::duration latency;  ///< submit() to completion
+   };
+
+   AsyncPoller();
+   ~AsyncPoller();
+
+   AsyncPoller(const AsyncPoller&) = delete;
+   AsyncPoller& operator=(const AsyncPoller&) = delete;
+
+   /** @brief Start reading the cpu state
+    * @param connection established session, must not be used otherwise until its completion is collected
+    * @param context passed back with the completion
+    * @return false if the job could not be started, the error is logged
+    */
+   bool submit(S7Connection& connection, void* context);
+   /** @brief Move the finished requests to completions
+    *
+    * Errors are checked on the connection, so a dead link is dropped here.
+    * @return number of collected completions
+    */
+   size_t collect(std::vector<Completion>& completions);
+   /** @brief eventfd, readable while completions are queued */
+   int fd() const { return eventFd; }
+   /** @brief Number of submitted requests not collected yet */
+   size_t in_flight() const { return inFlight; }
+
+private:
+   struct Request {
+      AsyncPoller* poller;
+      S7Connection* connection;
+      void* context;
+      TS7SmallSZL szl;
+      int size;
+      int result;
+      clock::time_point start;
+   };
+
+   static void S7API completion(void* usrPtr, int opCode, int opResult);
+
+   int eventFd;
+   std::map<S7Connection*, std::unique_ptr<Request>> requests;  ///< one reusable request per connection
+   std::mutex mutex;
+   std::vector<Request*> finished;
+   std::atomic<size_t> inFlight { 0 };
+};
+
+#endif /* PLC_ASYNCPOLLER_H_ */
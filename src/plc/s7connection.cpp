@@ -0,0 +1,128 @@
+/*
+ * s7connection.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <algorithm>
+#include "s7connection.h"
+#include "log.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+/** @brief Decide whether an error code means the session is gone
+ *
+ * The low word carries socket errors, the next nibble ISO errors. Timeouts and
+ * garbage answers are treated as a dead link as well, the next connect() starts over.
+ */
+static bool link_error(int result) {
+   if (result <= 0) {
+      return false; // success or library error (invalid object / parameter)
+   }
+   longword code = (longword) result;
+   if (code & 0x000FFFFF) {
+      return true; // TCP or ISO error
+   }
+   code &= 0xFFF00000;
+   return code == errCliJobTimeout || code == errCliInvalidPlcAnswer || code == errNegotiatingPDU;
+}
+
+S7Connection::S7Connection(const string& ip, int rack, int slot) :
+      address(ip), rackNo(rack), slotNo(slot) {
+}
+
+S7Connection::~S7Connection() {
+   disconnect();
+}
+
+void S7Connection::set_backoff(clock::duration min, clock::duration max) {
+   backoffMin = min;
+   backoffMax = std::max(min, max);
+}
+
+bool S7Connection::connect() {
+   if (established) {
+      if (s7Client.Connected()) {
+         return true;
+      }
+      drop("link lost");
+   }
+
+   clock::time_point start = clock::now();
+   if (start < nextAttempt) {
+      return false; // backoff running
+   }
+
+   ++attemptCount;
+   lastResult = s7Client.ConnectTo(address.c_str(), rackNo, slotNo);
+   if (!check(lastResult, "s7Client.ConnectTo()")) {
+      s7Client.Disconnect();
+      backoff = (backoff == clock::duration::zero()) ? backoffMin : std::min(backoff * 2, backoffMax);
+      nextAttempt = clock::now() + backoff;
+      tcout() << address << ": next connect in " << duration_cast<milliseconds>(backoff).count() << " ms" << endl;
+      return false;
+   }
+
+   lastLatency = clock::now() - start;
+   established = true;
+   backoff = clock::duration::zero();
+   if (everConnected) {
+      ++reconnectCount;
+      tcout() << address << ": S7 session re-established (reconnect #" << reconnectCount << ") in "
+            << duration_cast<milliseconds>(lastLatency).count() << " ms" << endl;
+   } else {
+      tcout() << address << ": S7 session established in " << duration_cast<milliseconds>(lastLatency).count()
+            << " ms, PDU " << s7Client.PDULength() << " bytes" << endl;
+   }
+   everConnected = true;
+   return true;
+}
+
+void S7Connection::disconnect() {
+   if (s7Client.Connected()) {
+      tcout() << address << ": Disconnect from PLC" << endl;
+      check(s7Client.Disconnect(), "s7Client.Disconnect()");
+   }
+   established = false;
+}
+
+void S7Connection::drop(const char* reason) {
+   tcerr() << address << ": S7 session dropped (" << reason << ")" << endl;
+   s7Client.Disconnect();
+   established = false;
+}
+
+bool S7Connection::check(int result, const char* function) {
+   if (result == 0) {
+      return true;
+   }
+   if (result < 0) {
+      tcerr() << address << ": " << function << ": library error (" << result << ")" << endl;
+   } else {
+      tcerr() << address << ": " << function << ": " << CliErrorText(result) << endl;
+   }
+   if (established && (link_error(result) || link_error(s7Client.LastError()) || !s7Client.Connected())) {
+      drop(function);
+   }
+   return false;
+}
+
+bool S7Connection::read_health(PlcHealth& health) {
+   TS7SmallSZL szl;
+   int size = sizeof(szl);
+   health = PlcHealth();
+   if (!check(s7Client.ReadSZL(SzlCpuStatus, 0, reinterpret_cast<PS7SZL>(&szl), &size), "s7Client.ReadSZL()")) {
+      return false;
+   }
+   return szl_health(szl, size, health);
+}
+
+int S7Connection::mode_switch() {
+   TS7Protection protection;
+   if (!check(s7Client.GetProtection(&protection), "s7Client.GetProtection()")) {
+      return -1;
+   }
+   return protection.bart_sch;
+}
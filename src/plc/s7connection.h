@@ -0,0 +1,98 @@
+/*
+ * s7connection.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PLC_S7CONNECTION_H_
+#define PLC_S7CONNECTION_H_
+
+#include <chrono>
+#include <string>
+#include "snap7.h"
+#include "szl.h"
+
+/** @brief Persistent S7 session to a single PLC
+ *
+ * The session is kept open across poll cycles. A dead link is detected from the result
+ * of each request, LastError() and Connected(). Reconnects are attempted with bounded
+ * exponential backoff, so an unreachable PLC costs at most one connect per backoff period.
+ */
+class S7Connection {
+public:
+   typedef std::chrono::steady_clock clock;
+
+   /** @brief Create a connection, the session is established by connect()
+    * @param ip address of the plc
+    * @param rack rack of the plc
+    * @param slot slot of the plc
+    */
+   S7Connection(const std::string& ip, int rack, int slot);
+   ~S7Connection();
+
+   S7Connection(const S7Connection&) = delete;
+   S7Connection& operator=(const S7Connection&) = delete;
+
+   /** @brief Make sure the session is established
+    * @return true if the session is usable, false if the connect failed or the backoff is still running
+    */
+   bool connect();
+   /** @brief Close the session */
+   void disconnect();
+   /** @brief Check the result of a request issued on client() and drop the session on link errors
+    * @param result error code
+    * @param function Name of the function the result is from
+    * @return true on success
+    */
+   bool check(int result, const char* function);
+   /** @brief Read the health snapshot of the plc in a single request
+    * @param health snapshot, status is S7CpuStatusUnknown on error
+    * @return false on error
+    */
+   bool read_health(PlcHealth& health);
+   /** @brief Read the position of the mode switch, costs an extra request
+    * @return 1 RUN, 2 RUN-P, 3 STOP, 4 MRES or -1 on error
+    */
+   int mode_switch();
+
+   /** @brief Set the bounds of the reconnect backoff
+    * @param min backoff after the first failed connect
+    * @param max upper bound of the backoff
+    */
+   void set_backoff(clock::duration min, clock::duration max);
+
+   TS7Client& client() { return s7Client; }
+   bool connected() const { return established; }
+   const std::string& ip() const { return address; }
+   int rack() const { return rackNo; }
+   int slot() const { return slotNo; }
+   /** @brief Number of successful connects after the first one */
+   unsigned long reconnects() const { return reconnectCount; }
+   /** @brief Duration of the last successful connect */
+   clock::duration connect_latency() const { return lastLatency; }
+   /** @brief Number of connects attempted, i.e. not skipped by the backoff */
+   unsigned long attempts() const { return attemptCount; }
+   /** @brief Error code of the last attempted connect, 0 on success */
+   int connect_result() const { return lastResult; }
+
+private:
+   void drop(const char* reason);
+
+   std::string address;
+   int rackNo;
+   int slotNo;
+   TS7Client s7Client;
+   bool established = false;
+   bool everConnected = false;
+   unsigned long reconnectCount = 0;
+   unsigned long attemptCount = 0;
+   int lastResult = 0;
+   clock::duration lastLatency = clock::duration::zero();
+   clock::duration backoffMin = std::chrono::seconds(1);
+   clock::duration backoffMax = std::chrono::seconds(60);
+   clock::duration backoff = clock::duration::zero();
+   clock::time_point nextAttempt;
+};
+
+#endif /* PLC_S7CONNECTION_H_ */
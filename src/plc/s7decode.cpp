@@ -0,0 +1,234 @@
+/*
+ * s7decode.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <string.h>
+#include <initializer_list>
+#include "s7decode.h"
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define S7DECODE_X86
+#include <immintrin.h>
+#endif
+
+namespace s7 {
+
+//---------------------------------------------------------------------------
+// Scalar
+//---------------------------------------------------------------------------
+static void swap16_scalar(const void* src, void* dst, size_t count) {
+   const uint8_t* s = static_cast<const uint8_t*>(src);
+   uint8_t* d = static_cast<uint8_t*>(dst);
+   for (size_t i = 0; i < count; ++i, s += 2, d += 2) {
+      uint16_t v;
+      memcpy(&v, s, 2);
+      v = __builtin_bswap16(v);
+      memcpy(d, &v, 2);
+   }
+}
+
+static void swap32_scalar(const void* src, void* dst, size_t count) {
+   const uint8_t* s = static_cast<const uint8_t*>(src);
+   uint8_t* d = static_cast<uint8_t*>(dst);
+   for (size_t i = 0; i < count; ++i, s += 4, d += 4) {
+      uint32_t v;
+      memcpy(&v, s, 4);
+      v = __builtin_bswap32(v);
+      memcpy(d, &v, 4);
+   }
+}
+
+static void swap64_scalar(const void* src, void* dst, size_t count) {
+   const uint8_t* s = static_cast<const uint8_t*>(src);
+   uint8_t* d = static_cast<uint8_t*>(dst);
+   for (size_t i = 0; i < count; ++i, s += 8, d += 8) {
+      uint64_t v;
+      memcpy(&v, s, 8);
+      v = __builtin_bswap64(v);
+      memcpy(d, &v, 8);
+   }
+}
+
+#ifdef S7DECODE_X86
+//---------------------------------------------------------------------------
+// SSE2, no byte shuffle: swap the bytes of each word, then the words
+//---------------------------------------------------------------------------
+static inline __m128i bswap16_sse2(__m128i x) {
+   return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+static void swap16_sse2(const void* src, void* dst, size_t count) {
+   const uint8_t* s = static_cast<const uint8_t*>(src);
+   uint8_t* d = static_cast<uint8_t*>(dst);
+   size_t i = 0;
+   for (; i + 8 <= count; i += 8, s += 16, d += 16) {
+      _mm_storeu_si128((__m128i*) d, bswap16_sse2(_mm_loadu_si128((const __m128i*) s)));
+   }
+   swap16_scalar(s, d, count - i);
+}
+
+static void swap32_sse2(const void* src, void* dst, size_t count) {
+   const uint8_t* s = static_cast<const uint8_t*>(src);
+   uint8_t* d = static_cast<uint8_t*>(dst);
+   size_t i = 0;
+   for (; i + 4 <= count; i += 4, s += 16, d += 16) {
+      __m128i x = _mm_loadu_si128((const __m128i*) s);
+      x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1);
+      _mm_storeu_si128((__m128i*) d, bswap16_sse2(x));
+   }
+   swap32_scalar(s, d, count - i);
+}
+
+static void swap64_sse2(const void* src, void* dst, size_t count) {
+   const uint8_t* s = static_cast<const uint8_t*>(src);
+   uint8_t* d = static_cast<uint8_t*>(dst);
+   size_t i = 0;
+   for (; i + 2 <= count; i += 2, s += 16, d += 16) {
+      __m128i x = _mm_loadu_si128((const __m128i*) s);
+      x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0x1B), 0x1B);
+      _mm_storeu_si128((__m128i*) d, bswap16_sse2(x));
+   }
+   swap64_scalar(s, d, count - i);
+}
+
+//---------------------------------------------------------------------------
+// AVX2, one byte shuffle per 32 bytes
+//---------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static void swap_avx2(const uint8_t* s, uint8_t* d, size_t bytes, __m256i mask) {
+   size_t i = 0;
+   for (; i + 64 <= bytes; i += 64) {
+      __m256i a = _mm256_loadu_si256((const __m256i*) (s + i));
+      __m256i b = _mm256_loadu_si256((const __m256i*) (s + i + 32));
+      _mm256_storeu_si256((__m256i*) (d + i), _mm256_shuffle_epi8(a, mask));
+      _mm256_storeu_si256((__m256i*) (d + i + 32), _mm256_shuffle_epi8(b, mask));
+   }
+   for (; i + 32 <= bytes; i += 32) {
+      _mm256_storeu_si256((__m256i*) (d + i), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*) (s + i)), mask));
+   }
+}
+
+__attribute__((target("avx2")))
+static void swap16_avx2(const void* src, void* dst, size_t count) {
+   const __m256i mask = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+         1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+   size_t n = count & ~(size_t) 15;
+   swap_avx2(static_cast<const uint8_t*>(src), static_cast<uint8_t*>(dst), n * 2, mask);
+   swap16_sse2(static_cast<const uint8_t*>(src) + n * 2, static_cast<uint8_t*>(dst) + n * 2, count - n);
+}
+
+__attribute__((target("avx2")))
+static void swap32_avx2(const void* src, void* dst, size_t count) {
+   const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+         3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+   size_t n = count & ~(size_t) 7;
+   swap_avx2(static_cast<const uint8_t*>(src), static_cast<uint8_t*>(dst), n * 4, mask);
+   swap32_sse2(static_cast<const uint8_t*>(src) + n * 4, static_cast<uint8_t*>(dst) + n * 4, count - n);
+}
+
+__attribute__((target("avx2")))
+static void swap64_avx2(const void* src, void* dst, size_t count) {
+   const __m256i mask = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+         7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+   size_t n = count & ~(size_t) 3;
+   swap_avx2(static_cast<const uint8_t*>(src), static_cast<uint8_t*>(dst), n * 8, mask);
+   swap64_sse2(static_cast<const uint8_t*>(src) + n * 8, static_cast<uint8_t*>(dst) + n * 8, count - n);
+}
+#endif
+
+//---------------------------------------------------------------------------
+// Dispatch
+//---------------------------------------------------------------------------
+typedef void (*SwapFn)(const void*, void*, size_t);
+
+struct Kernels {
+   Isa isa;
+   SwapFn swap16;
+   SwapFn swap32;
+   SwapFn swap64;
+};
+
+static const Kernels scalar = { Isa::Scalar, swap16_scalar, swap32_scalar, swap64_scalar };
+#ifdef S7DECODE_X86
+static const Kernels sse2 = { Isa::SSE2, swap16_sse2, swap32_sse2, swap64_sse2 };
+static const Kernels avx2 = { Isa::AVX2, swap16_avx2, swap32_avx2, swap64_avx2 };
+#endif
+
+static bool supported(Isa isa) {
+   switch (isa) {
+   case Isa::Scalar:
+      return true;
+#ifdef S7DECODE_X86
+   case Isa::SSE2:
+      return true;
+   case Isa::AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+   default:
+      return false;
+   }
+}
+
+static const Kernels* kernels_of(Isa isa) {
+#ifdef S7DECODE_X86
+   if (isa == Isa::AVX2) {
+      return &avx2;
+   }
+   if (isa == Isa::SSE2) {
+      return &sse2;
+   }
+#endif
+   return &scalar;
+}
+
+static const Kernels* best() {
+   for (Isa isa : { Isa::AVX2, Isa::SSE2 }) {
+      if (supported(isa)) {
+         return kernels_of(isa);
+      }
+   }
+   return &scalar;
+}
+
+static const Kernels* active = best();
+
+Isa decode_isa() {
+   return active->isa;
+}
+
+const char* isa_name(Isa isa) {
+   switch (isa) {
+   case Isa::SSE2:
+      return "SSE2";
+   case Isa::AVX2:
+      return "AVX2";
+   default:
+      return "scalar";
+   }
+}
+
+bool set_decode_isa(Isa isa) {
+   if (!supported(isa)) {
+      return false;
+   }
+   active = kernels_of(isa);
+   return true;
+}
+
+void swap16(const void* src, void* dst, size_t count) {
+   active->swap16(src, dst, count);
+}
+
+void swap32(const void* src, void* dst, size_t count) {
+   active->swap32(src, dst, count);
+}
+
+void swap64(const void* src, void* dst, size_t count) {
+   active->swap64(src, dst, count);
+}
+
+} // namespace s7
@@ -0,0 +1,72 @@
+/*
+ * s7decode.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PLC_S7DECODE_H_
+#define PLC_S7DECODE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Bulk conversion of big endian S7 arrays to host order
+ *
+ * The byte swap runs on AVX2 or SSE2 if the cpu supports it, otherwise on a scalar loop. The
+ * implementation is selected once at startup. All functions accept src == dst to convert a
+ * buffer in place, other overlaps are not allowed.
+ */
+namespace s7 {
+
+/** @brief Implementation of the bulk conversion */
+enum class Isa {
+   Scalar, SSE2, AVX2
+};
+
+/** @brief Currently used implementation */
+Isa decode_isa();
+/** @brief Name of an implementation */
+const char* isa_name(Isa isa);
+/** @brief Select an implementation, e.g. to compare them
+ * @return false if the cpu does not support it
+ */
+bool set_decode_isa(Isa isa);
+
+/** @brief Swap count 16 bit values from src to dst */
+void swap16(const void* src, void* dst, size_t count);
+/** @brief Swap count 32 bit values from src to dst */
+void swap32(const void* src, void* dst, size_t count);
+/** @brief Swap count 64 bit values from src to dst */
+void swap64(const void* src, void* dst, size_t count);
+
+/** @brief Typed front ends, e.g. decode(buffer, reals, n) for an ARRAY OF REAL */
+inline void decode(const void* src, int16_t* dst, size_t count) { swap16(src, dst, count); }
+inline void decode(const void* src, uint16_t* dst, size_t count) { swap16(src, dst, count); }
+inline void decode(const void* src, int32_t* dst, size_t count) { swap32(src, dst, count); }
+inline void decode(const void* src, uint32_t* dst, size_t count) { swap32(src, dst, count); }
+inline void decode(const void* src, float* dst, size_t count) { swap32(src, dst, count); }
+inline void decode(const void* src, int64_t* dst, size_t count) { swap64(src, dst, count); }
+inline void decode(const void* src, uint64_t* dst, size_t count) { swap64(src, dst, count); }
+inline void decode(const void* src, double* dst, size_t count) { swap64(src, dst, count); }
+
+/** @brief Read an array with a single ReadArea() and convert it in place
+ * @param client TS7Client
+ * @param area S7AreaDB, S7AreaMK, S7AreaPE or S7AreaPA
+ * @param dbNumber number of the DB
+ * @param start byte offset of the first element
+ * @param values receives count host order values
+ * @return snap7 result of the ReadArea()
+ */
+template<typename Client, typename T> int read_array(Client& client, int area, int dbNumber, int start, T* values,
+      size_t count) {
+   int result = client.ReadArea(area, dbNumber, start, (int) (count * sizeof(T)), 0x02 /* S7WLByte */, values);
+   if (result == 0) {
+      decode(values, values, count);
+   }
+   return result;
+}
+
+} // namespace s7
+
+#endif /* PLC_S7DECODE_H_ */
@@ -0,0 +1,103 @@
+/*
+ * s7layout.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PLC_S7LAYOUT_H_
+#define PLC_S7LAYOUT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "s7decode.h"
+
+/** @brief Big endian accessors used by the DB layouts generated with s7dbgen
+ *
+ * Offsets are compile time constants of the generated code, the loads below compile
+ * to a plain (byte swapped) memory access. Numeric arrays are converted in bulk, see s7decode.h.
+ */
+namespace s7 {
+
+/** @brief Load a big endian value */
+template<typename T> inline T load(const uint8_t* p);
+
+template<> inline uint8_t load<uint8_t>(const uint8_t* p) { return p[0]; }
+template<> inline int8_t load<int8_t>(const uint8_t* p) { return (int8_t) p[0]; }
+template<> inline char load<char>(const uint8_t* p) { return (char) p[0]; }
+
+template<> inline uint16_t load<uint16_t>(const uint8_t* p) {
+   uint16_t v;
+   memcpy(&v, p, sizeof(v));
+   return __builtin_bswap16(v);
+}
+template<> inline int16_t load<int16_t>(const uint8_t* p) { return (int16_t) load<uint16_t>(p); }
+
+template<> inline uint32_t load<uint32_t>(const uint8_t* p) {
+   uint32_t v;
+   memcpy(&v, p, sizeof(v));
+   return __builtin_bswap32(v);
+}
+template<> inline int32_t load<int32_t>(const uint8_t* p) { return (int32_t) load<uint32_t>(p); }
+
+template<> inline uint64_t load<uint64_t>(const uint8_t* p) {
+   uint64_t v;
+   memcpy(&v, p, sizeof(v));
+   return __builtin_bswap64(v);
+}
+template<> inline int64_t load<int64_t>(const uint8_t* p) { return (int64_t) load<uint64_t>(p); }
+
+template<> inline float load<float>(const uint8_t* p) {
+   uint32_t u = load<uint32_t>(p);
+   float f;
+   memcpy(&f, &u, sizeof(f));
+   return f;
+}
+template<> inline double load<double>(const uint8_t* p) {
+   uint64_t u = load<uint64_t>(p);
+   double d;
+   memcpy(&d, &u, sizeof(d));
+   return d;
+}
+
+/** @brief Load a bit of a Bool */
+inline bool load_bit(const uint8_t* p, int bit) {
+   return (p[0] >> bit) & 1;
+}
+
+/** @brief S7 STRING[N]: max length, actual length and the characters */
+template<size_t N> struct String {
+   uint8_t length = 0;
+   char text[N + 1] = {};
+
+   void load(const uint8_t* p) {
+      length = p[1] > N ? N : p[1];
+      memcpy(text, p + 2, length);
+      text[length] = '\0';
+   }
+};
+
+/** @brief Position of a member in a DB */
+struct Field {
+   int byte;   ///< byte offset
+   int bit;    ///< bit number of a Bool, 0 otherwise
+};
+
+/** @brief Read a whole DB with a single DBRead() and decode it
+ *
+ * Layout is a struct generated by s7dbgen, Client a TS7Client.
+ * @return snap7 result of the DBRead()
+ */
+template<typename Layout, typename Client> int read_db(Client& client, int dbNumber, Layout& layout) {
+   uint8_t buffer[Layout::size];
+   int result = client.DBRead(dbNumber, 0, Layout::size, buffer);
+   if (result == 0) {
+      layout.decode(buffer);
+   }
+   return result;
+}
+
+} // namespace s7
+
+#endif /* PLC_S7LAYOUT_H_ */
@@ -0,0 +1,80 @@
+/*
+ * szl.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PLC_SZL_H_
+#define PLC_SZL_H_
+
+#include <stdint.h>
+#include "snap7.h"
+
+/** @brief SZL W#16#0424, current mode transition of the cpu */
+const int SzlCpuStatus = 0x0424;
+
+/** @brief Small SZL buffer for answers fitting into a single PDU
+ *
+ * Layout compatible with the head of TS7SZL, pass it casted to PS7SZL together with its size.
+ */
+struct TS7SmallSZL {
+   SZL_HEADER Header;
+   byte Data[480];
+};
+
+/** @brief Health of a plc, taken from a single W#16#0424 answer
+ *
+ * Besides the cpu state the record carries the diagnostic event of the last mode transition
+ * and its time stamp, the head of the diagnostic buffer as far as mode changes are concerned.
+ * A changed transition while the state looks the same means the cpu went through another
+ * mode between two polls. The position of the mode switch is not part of W#16#0424, it is
+ * read by S7Connection::mode_switch() once a STOP is to be announced.
+ */
+struct PlcHealth {
+   int status = S7CpuStatusUnknown;    ///< S7CpuStatusRun, S7CpuStatusStop or S7CpuStatusUnknown
+   int previous = 0;                   ///< mode before the last transition (bzu-id bits 4..7)
+   word event = 0;                     ///< diagnostic event id of the last mode transition
+   uint64_t eventTime = 0;             ///< BCD time stamp of the last mode transition
+
+   /** @brief Identity of the last mode transition */
+   bool same_transition(const PlcHealth& other) const {
+      return event == other.event && eventTime == other.eventTime;
+   }
+};
+
+/** @brief Decode a W#16#0424 answer
+ *
+ * The cpu state is taken from the same byte (bzu-id) PlcStatus() evaluates: RUN is 0x08, STOP is
+ * 0x04 but coded 0x03 by some older cpus. PlcStatus() compares the whole byte and reports every
+ * other value as STOP. Here the low nibble decides, because the high nibble holds the mode before
+ * the last transition (see previous); a RUN cpu with such bits set is still RUN. For a byte with a
+ * clear high nibble both give the same state.
+ * @param szl answer of ReadSZL(SzlCpuStatus, 0, ...)
+ * @param size number of bytes read
+ * @param health decoded snapshot
+ * @return false if the answer holds no record
+ */
+inline bool szl_health(const TS7SmallSZL& szl, int size, PlcHealth& health) {
+   health = PlcHealth();
+   if (size < 4 || szl.Header.N_DR < 1) {
+      return false;
+   }
+   const byte* record = szl.Data;
+   byte bzu = record[3];
+   if (bzu == S7CpuStatusRun || bzu == S7CpuStatusUnknown) {
+      health.status = bzu;
+   } else {
+      health.status = (bzu & 0x0F) == S7CpuStatusRun ? S7CpuStatusRun : S7CpuStatusStop;
+   }
+   health.previous = bzu >> 4;
+   health.event = (word) (record[0] << 8 | record[1]);
+   if (szl.Header.LENTHDR >= 20) {
+      for (int i = 12; i < 20; ++i) {
+         health.eventTime = health.eventTime << 8 | record[i];
+      }
+   }
+   return true;
+}
+
+#endif /* PLC_SZL_H_ */
@@ -0,0 +1,255 @@
+/*
+ * tag.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <ctype.h>
+#include <string.h>
+#include <sstream>
+#include "tag.h"
+#include "watchlist.h"
+
+using namespace std;
+
+/** @brief Parse an unsigned decimal number, advance p */
+static bool number(const char*& p, int& value, int max) {
+   if (!isdigit((unsigned char) *p)) {
+      return false;
+   }
+   long v = 0;
+   while (isdigit((unsigned char) *p)) {
+      v = v * 10 + (*p++ - '0');
+      if (v > max) {
+         return false;
+      }
+   }
+   value = (int) v;
+   return true;
+}
+
+/** @brief Consume a case insensitive keyword */
+static bool keyword(const char*& p, const char* word) {
+   size_t n = strlen(word);
+   if (strncasecmp(p, word, n) != 0) {
+      return false;
+   }
+   p += n;
+   return true;
+}
+
+/** @brief Parse the size letter X, B, W or D and the byte (and bit) offset */
+static bool offset(const char*& p, bool bitAddress, TagAddress& address) {
+   if (!bitAddress) {
+      switch (toupper((unsigned char) *p)) {
+      case 'X':
+         bitAddress = true;
+         ++p;
+         break;
+      case 'B':
+         address.size = 1;
+         address.type = TagType::Byte;
+         ++p;
+         break;
+      case 'W':
+         address.size = 2;
+         address.type = TagType::Word;
+         ++p;
+         break;
+      case 'D':
+         address.size = 4;
+         address.type = TagType::DWord;
+         ++p;
+         break;
+      default:
+         bitAddress = true; // M12.3
+         break;
+      }
+   }
+   if (!number(p, address.start, 65535)) {
+      return false;
+   }
+   if (bitAddress) {
+      address.size = 1;
+      address.type = TagType::Bool;
+      return *p++ == '.' && number(p, address.bit, 7);
+   }
+   return true;
+}
+
+/** @brief Apply a :TYPE suffix, the type must match the size of the address */
+static bool type(const char* p, TagAddress& address) {
+   static const struct {
+      const char* name;
+      TagType type;
+      int size;
+   } types[] = {
+      { "BOOL", TagType::Bool, 0 }, { "BYTE", TagType::Byte, 1 }, { "CHAR", TagType::Char, 1 },
+      { "SINT", TagType::SInt, 1 }, { "USINT", TagType::Byte, 1 }, { "WORD", TagType::Word, 2 },
+      { "UINT", TagType::Word, 2 }, { "INT", TagType::Int, 2 }, { "DWORD", TagType::DWord, 4 },
+      { "UDINT", TagType::DWord, 4 }, { "DINT", TagType::DInt, 4 }, { "REAL", TagType::Real, 4 },
+   };
+   for (const auto& t : types) {
+      if (strcasecmp(p, t.name) == 0) {
+         bool bit = address.type == TagType::Bool;
+         if (bit != (t.size == 0) || (!bit && t.size != address.size)) {
+            return false;
+         }
+         address.type = t.type;
+         return true;
+      }
+   }
+   return false;
+}
+
+bool parse_tag_address(const char* text, TagAddress& address) {
+   const char* p = text;
+   TagAddress a;
+   bool ok;
+
+   if (keyword(p, "DB")) {
+      a.area = S7AreaDB;
+      ok = number(p, a.dbNumber, 65535) && a.dbNumber > 0 && *p++ == '.' && keyword(p, "DB") && offset(p, false, a);
+   } else {
+      switch (toupper((unsigned char) *p++)) {
+      case 'M':
+         a.area = S7AreaMK;
+         break;
+      case 'E':
+      case 'I':
+         a.area = S7AreaPE;
+         break;
+      case 'A':
+      case 'Q':
+         a.area = S7AreaPA;
+         break;
+      default:
+         return false;
+      }
+      ok = offset(p, false, a);
+   }
+   if (!ok) {
+      return false;
+   }
+   if (*p == ':' && !type(p + 1, a)) {
+      return false;
+   } else if (*p != ':' && *p != '\0') {
+      return false;
+   }
+
+   switch (a.type) {
+   case TagType::Bool:
+      a.wordLen = S7WLBit;
+      break;
+   case TagType::Byte:
+   case TagType::Char:
+   case TagType::SInt:
+      a.wordLen = S7WLByte;
+      break;
+   case TagType::Word:
+   case TagType::Int:
+      a.wordLen = S7WLWord;
+      break;
+   case TagType::DWord:
+   case TagType::DInt:
+      a.wordLen = S7WLDWord;
+      break;
+   case TagType::Real:
+      a.wordLen = S7WLReal;
+      break;
+   }
+   address = a;
+   return true;
+}
+
+double decode_tag(const TagAddress& address, const ::byte* data) {
+   uint32_t u;
+   switch (address.type) {
+   case TagType::Bool:
+      return (data[0] >> address.bit) & 1;
+   case TagType::Byte:
+   case TagType::Char:
+      return data[0];
+   case TagType::SInt:
+      return (int8_t) data[0];
+   case TagType::Word:
+      return (uint16_t) (data[0] << 8 | data[1]);
+   case TagType::Int:
+      return (int16_t) (data[0] << 8 | data[1]);
+   default:
+      break;
+   }
+   u = (uint32_t) data[0] << 24 | (uint32_t) data[1] << 16 | (uint32_t) data[2] << 8 | data[3];
+   switch (address.type) {
+   case TagType::DInt:
+      return (int32_t) u;
+   case TagType::Real: {
+      float f;
+      memcpy(&f, &u, sizeof(f));
+      return f;
+   }
+   default:
+      return u;
+   }
+}
+
+string format_tag(const TagIndex::Tag& tag) {
+   ostringstream os;
+   switch (tag.address.type) {
+   case TagType::Bool:
+      os << (tag.value != 0 ? "TRUE" : "FALSE");
+      break;
+   case TagType::Char:
+      os << "'" << (char) tag.value << "'";
+      break;
+   case TagType::Byte:
+   case TagType::Word:
+   case TagType::DWord:
+      os << "16#" << hex << uppercase << (uint32_t) tag.value;
+      break;
+   default:
+      os << tag.value;
+      break;
+   }
+   return os.str();
+}
+
+TagIndex::TagIndex(Watchlist& list) :
+      watchlist(list) {
+}
+
+bool TagIndex::add(const string& name, const TagAddress& address) {
+   if (!names.emplace(name, tags.size()).second) {
+      return false;
+   }
+   Tag tag;
+   tag.name = name;
+   tag.address = address;
+   tag.watch = watchlist.add(address);
+   tags.push_back(tag);
+   return true;
+}
+
+void TagIndex::clear() {
+   tags.clear();
+   names.clear();
+   watchlist.clear();
+}
+
+size_t TagIndex::find(const string& name) const {
+   auto it = names.find(name);
+   return it == names.end() ? npos : it->second;
+}
+
+size_t TagIndex::update() {
+   size_t changes = 0;
+   for (Tag& tag : tags) {
+      double value = decode_tag(tag.address, watchlist.data(tag.watch));
+      tag.changed = !tag.valid || value != tag.value;
+      tag.value = value;
+      tag.valid = true;
+      changes += tag.changed;
+   }
+   return changes;
+}
@@ -0,0 +1,110 @@
+/*
+ * tag.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PLC_TAG_H_
+#define PLC_TAG_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "snap7.h"
+
+/** @brief Data type of a tag, decides how its bytes are decoded */
+enum class TagType {
+   Bool, Byte, Char, SInt, Word, Int, DWord, DInt, Real
+};
+
+/** @brief Address of a watched value in the plc
+ *
+ * area and dbNumber map onto the fields of a TS7DataItem, start is the byte offset of every tag.
+ * For S7WLBit snap7 expects Start = byte * 8 + bit instead, so a bit tag can not be passed through;
+ * the Watchlist reads all tags as S7WLByte ranges and takes the bit from the byte.
+ */
+struct TagAddress {
+   int area = S7AreaDB;       ///< S7AreaDB, S7AreaMK, S7AreaPE or S7AreaPA
+   int dbNumber = 0;          ///< number of the DB, 0 for other areas
+   int start = 0;             ///< byte offset
+   int bit = 0;               ///< bit number 0..7 of S7WLBit tags
+   int size = 1;              ///< size in bytes
+   int wordLen = S7WLByte;    ///< S7WLBit, S7WLByte, S7WLWord, S7WLDWord or S7WLReal
+   TagType type = TagType::Byte;
+};
+
+inline bool operator==(const TagAddress& a, const TagAddress& b) {
+   return a.area == b.area && a.dbNumber == b.dbNumber && a.start == b.start && a.bit == b.bit && a.size == b.size
+         && a.wordLen == b.wordLen && a.type == b.type;
+}
+
+/** @brief Parse an S7 address
+ *
+ * Accepted are DB addresses (DB10.DBX0.0, DB10.DBB1, DB10.DBW2, DB10.DBD4) and merker, input and
+ * output addresses in german or english mnemonics (M12.3, MB1, MW2, MD4, E0.1, I0.1, EB0, IW20,
+ * A4.0, Q4.0, AW2, QD8). The type follows from the size (BOOL, BYTE, WORD, DWORD) and can be set
+ * with a suffix of the same size, e.g. DB10.DBD4:REAL, MW2:INT, EB3:CHAR, MD8:DINT.
+ * @param text address, case insensitive
+ * @param address parsed address
+ * @return false if the text is no valid address
+ */
+bool parse_tag_address(const char* text, TagAddress& address);
+
+/** @brief Decode the value of a tag
+ * @param address tag address
+ * @param data raw big endian bytes of the tag
+ */
+double decode_tag(const TagAddress& address, const byte* data);
+
+class Watchlist;
+
+/** @brief Named tags of a plc with their current values
+ *
+ * Names are hashed once, rule and notification code looks up the slot of a tag once and
+ * reaches the value in O(1) afterwards. The values are decoded from the buffers of the
+ * watchlist the tags are registered in.
+ */
+class TagIndex {
+public:
+   struct Tag {
+      std::string name;
+      TagAddress address;
+      size_t watch;           ///< index in the watchlist
+      double value = 0;
+      bool valid = false;     ///< read at least once
+      bool changed = false;   ///< changed by the last update()
+   };
+
+   /** @param watchlist watchlist reading the tags, must outlive the index */
+   explicit TagIndex(Watchlist& watchlist);
+
+   /** @brief Add a tag and register it in the watchlist
+    * @return false if the name is in use
+    */
+   bool add(const std::string& name, const TagAddress& address);
+   /** @brief Remove all tags from the index and the watchlist */
+   void clear();
+   /** @brief Slot of a tag
+    * @return slot or npos if unknown
+    */
+   size_t find(const std::string& name) const;
+   const Tag& operator[](size_t slot) const { return tags[slot]; }
+   size_t size() const { return tags.size(); }
+   /** @brief Decode the values after a successful Watchlist::read()
+    * @return number of changed values
+    */
+   size_t update();
+
+   static const size_t npos = (size_t) -1;
+
+private:
+   Watchlist& watchlist;
+   std::vector<Tag> tags;
+   std::unordered_map<std::string, size_t> names;
+};
+
+/** @brief Print the value of a tag according to its type */
+std::string format_tag(const TagIndex::Tag& tag);
+
+#endif /* PLC_TAG_H_ */
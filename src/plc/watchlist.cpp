@@ -0,0 +1,151 @@
+/*
+ * watchlist.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <algorithm>
+#include "watchlist.h"
+#include "log.hpp"
+
+using namespace std;
+
+// S7 ReadVar framing, see the size checks of snap7's ReadMultiVars()
+static const int requestHeader = 19;   // telegram + parameter header of the request
+static const int requestItem = 12;     // address specification of an item
+static const int answerHeader = 14;    // telegram + parameter header of the answer
+static const int answerItem = 4;       // return code, transport size and length of an item
+
+size_t Watchlist::add(const TagAddress& address) {
+   Tag tag;
+   tag.address = address;
+   tags.push_back(tag);
+   plannedPdu = 0;
+   return tags.size() - 1;
+}
+
+void Watchlist::clear() {
+   tags.clear();
+   ranges.clear();
+   batches.clear();
+   plannedPdu = 0;
+}
+
+const ::byte* Watchlist::data(size_t tag) const {
+   const Tag& t = tags[tag];
+   return ranges[t.range].buffer.data() + t.offset;
+}
+
+void Watchlist::plan(int pduLength) {
+   ranges.clear();
+   batches.clear();
+
+   // sort by area, DB and offset to merge neighbours
+   vector<size_t> order(tags.size());
+   for (size_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+   }
+   sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+      const TagAddress& x = tags[a].address;
+      const TagAddress& y = tags[b].address;
+      if (x.area != y.area) {
+         return x.area < y.area;
+      }
+      if (x.dbNumber != y.dbNumber) {
+         return x.dbNumber < y.dbNumber;
+      }
+      return x.start < y.start;
+   });
+
+   // the largest item fitting into an answer, even to keep the items aligned
+   int maxItem = (pduLength - answerHeader - answerItem) & ~1;
+   size_t maxItems = min<size_t>(MaxVars, (pduLength - requestHeader) / requestItem);
+   // read gaps along while that is cheaper than another item, i.e. its framing or its share of a request
+   int mergeGap = max<int>(requestItem + answerItem, pduLength / maxItems);
+   for (size_t i : order) {
+      const TagAddress& a = tags[i].address;
+      Range* last = ranges.empty() ? NULL : &ranges.back();
+      int end = a.start + a.size;
+      if (last && last->area == a.area && last->dbNumber == a.dbNumber
+            && a.start <= last->start + last->size + mergeGap && end - last->start <= maxItem) {
+         last->size = max(last->size, end - last->start);
+      } else {
+         ranges.push_back(Range { a.area, a.dbNumber, a.start, a.size, vector< ::byte>() });
+      }
+      tags[i].range = ranges.size() - 1;
+      tags[i].offset = a.start - ranges.back().start;
+   }
+
+   // only a single tag can exceed an item, it is read with several items into the same buffer
+   vector<pair<size_t, int>> items; // range, offset in range
+   for (size_t r = 0; r < ranges.size(); ++r) {
+      ranges[r].buffer.assign(ranges[r].size, 0);
+      for (int offset = 0; offset < ranges[r].size; offset += maxItem) {
+         items.emplace_back(r, offset);
+      }
+   }
+
+   // pack the items into requests, largest first
+   auto itemSize = [&](const pair<size_t, int>& item) {
+      return min(maxItem, ranges[item.first].size - item.second);
+   };
+   stable_sort(items.begin(), items.end(), [&](const pair<size_t, int>& a, const pair<size_t, int>& b) {
+      return itemSize(a) > itemSize(b);
+   });
+   vector<int> answerSize;
+   for (const auto& item : items) {
+      int size = answerItem + ((itemSize(item) + 1) & ~1);
+      size_t b = 0;
+      while (b < batches.size() && (batches[b].size() >= maxItems || answerSize[b] + size > pduLength)) {
+         ++b;
+      }
+      if (b == batches.size()) {
+         batches.emplace_back();
+         answerSize.push_back(answerHeader);
+      }
+      Range& range = ranges[item.first];
+      TS7DataItem di;
+      di.Area = range.area;
+      di.WordLen = S7WLByte;
+      di.Result = 0;
+      di.DBNumber = range.dbNumber;
+      di.Start = range.start + item.second;
+      di.Amount = itemSize(item);
+      di.pdata = range.buffer.data() + item.second;
+      batches[b].push_back(di);
+      answerSize[b] += size;
+   }
+
+   plannedPdu = pduLength;
+   tcout() << "Watchlist: " << tags.size() << " tag(s) in " << ranges.size() << " range(s), " << batches.size()
+         << " request(s) per cycle with PDU " << pduLength << endl;
+}
+
+bool Watchlist::read(S7Connection& connection) {
+   if (tags.empty()) {
+      return true;
+   }
+   int pduLength = connection.client().PDULength();
+   if (pduLength <= answerHeader + answerItem + requestItem) {
+      return false;
+   }
+   if (pduLength != plannedPdu) {
+      plan(pduLength);
+   }
+
+   bool ok = true;
+   for (Batch& batch : batches) {
+      if (!connection.check(connection.client().ReadMultiVars(batch.data(), batch.size()), "s7Client.ReadMultiVars()")) {
+         return false;
+      }
+      for (const TS7DataItem& item : batch) {
+         if (item.Result != 0) {
+            tcerr() << connection.ip() << ": read of area 0x" << hex << item.Area << dec << " DB " << item.DBNumber
+                  << " offset " << item.Start << " failed: " << CliErrorText(item.Result) << endl;
+            ok = false;
+         }
+      }
+   }
+   return ok;
+}
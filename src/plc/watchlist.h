@@ -0,0 +1,68 @@
+/*
+ * watchlist.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PLC_WATCHLIST_H_
+#define PLC_WATCHLIST_H_
+
+#include <vector>
+#include "s7connection.h"
+#include "tag.h"
+
+/** @brief Reads a list of tags with the fewest possible round trips
+ *
+ * Tags of the same area and DB are merged into ranges where they overlap, touch or leave a
+ * gap cheaper to read than another item. Ranges are split to fit into a PDU and packed into
+ * ReadMultiVars() requests respecting the negotiated PDU length and the MaxVars limit.
+ * The read plan is built once and reused every cycle, it is rebuilt only if tags are added
+ * or the session negotiates another PDU length.
+ */
+class Watchlist {
+public:
+   /** @brief Add a tag
+    * @return index of the tag, used to access its value
+    */
+   size_t add(const TagAddress& address);
+   /** @brief Remove all tags */
+   void clear();
+   size_t size() const { return tags.size(); }
+   bool empty() const { return tags.empty(); }
+   const TagAddress& address(size_t tag) const { return tags[tag].address; }
+
+   /** @brief Read all tags
+    * @param connection established session
+    * @return false if a request failed, the values of the failed requests are stale
+    */
+   bool read(S7Connection& connection);
+   /** @brief Raw big endian bytes of a tag as read by the last read() */
+   const byte* data(size_t tag) const;
+   /** @brief Number of requests per read(), 0 before the first read() */
+   size_t requests() const { return batches.size(); }
+
+private:
+   struct Tag {
+      TagAddress address;
+      size_t range = 0;       ///< range holding the tag
+      int offset = 0;         ///< offset of the tag in the range
+   };
+   struct Range {
+      int area;
+      int dbNumber;
+      int start;
+      int size;
+      std::vector<byte> buffer;
+   };
+   typedef std::vector<TS7DataItem> Batch;
+
+   void plan(int pduLength);
+
+   std::vector<Tag> tags;
+   std::vector<Range> ranges;
+   std::vector<Batch> batches;
+   int plannedPdu = 0;        ///< PDU length of the current plan, 0 if outdated
+};
+
+#endif /* PLC_WATCHLIST_H_ */
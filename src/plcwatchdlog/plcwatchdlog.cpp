@@ -0,0 +1,399 @@
+/*
+ * plcwatchdlog.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ *
+ * Decodes the binary event log of plcwatchd into JSON lines or CSV.
+ *
+ *   plcwatchd-log [-c] [-p plc] [-e event] [-s time] [-u time] directory|segment ...
+ *
+ * The output is formatted by hand into a large buffer, the segments are read through their
+ * mapping, so the decoder is bound by the write of its output.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "eventlog.h"
+#include "snap7.h"
+
+using namespace std;
+
+static const char* const eventNames[] = { "", "plc", "connect", "status", "push", "receipt", "hotstart" };
+static const char* const receiptStates[] = { "issued", "failed", "acknowledged", "expired", "cancelled" };
+
+/** @brief Output buffer written to stdout in large blocks */
+class Output {
+public:
+   Output() :
+         buffer(new char[capacity]) {
+   }
+   ~Output() {
+      flush();
+      delete[] buffer;
+   }
+
+   void flush() {
+      if (used && fwrite(buffer, 1, used, stdout) != used) {
+         perror("plcwatchd-log");
+         exit(EXIT_FAILURE);
+      }
+      used = 0;
+   }
+   /** @brief Make room for size bytes */
+   char* reserve(size_t size) {
+      if (used + size > capacity) {
+         flush();
+      }
+      return buffer + used;
+   }
+   /** @brief Take over size bytes written behind reserve() */
+   void commit(size_t size) {
+      used += size;
+   }
+   void put(const char* s, size_t size) {
+      memcpy(reserve(size), s, size);
+      commit(size);
+   }
+   template<size_t N>
+   void put(const char (&s)[N]) {
+      put(s, N - 1);
+   }
+   void name(const char* s) {
+      put(s, strlen(s));
+   }
+   void put(char c) {
+      *reserve(1) = c;
+      commit(1);
+   }
+   void number(long long value) {
+      char* p = reserve(24);
+      unsigned long long v = value < 0 ? -(unsigned long long) value : value;
+      char digits[20];
+      int n = 0;
+      do {
+         digits[n++] = '0' + v % 10;
+         v /= 10;
+      } while (v);
+      if (value < 0) {
+         *p++ = '-';
+      }
+      while (n) {
+         *p++ = digits[--n];
+      }
+      commit(p - (buffer + used));
+   }
+   void hex(unsigned value, int width) {
+      char* p = reserve(width);
+      for (int i = width - 1; i >= 0; --i, value >>= 4) {
+         p[i] = "0123456789abcdef"[value & 15];
+      }
+      commit(width);
+   }
+   /** @brief Text as JSON string including the quotes */
+   void json(const char* s, size_t size) {
+      put('"');
+      size_t plain = 0;
+      while (plain < size && s[plain] != '"' && s[plain] != '\\' && (unsigned char) s[plain] >= 0x20) {
+         ++plain;
+      }
+      put(s, plain);
+      for (size_t i = plain; i < size; ++i) {
+         unsigned char c = s[i];
+         if (c == '"' || c == '\\') {
+            put('\\');
+            put((char) c);
+         } else if (c < 0x20) {
+            put("\\u00", 4);
+            hex(c, 2);
+         } else {
+            put((char) c);
+         }
+      }
+      put('"');
+   }
+   /** @brief Text as CSV field, quoted if needed */
+   void csv(const char* s, size_t size) {
+      if (!memchr(s, ',', size) && !memchr(s, '"', size) && !memchr(s, '\n', size)) {
+         put(s, size);
+         return;
+      }
+      put('"');
+      for (size_t i = 0; i < size; ++i) {
+         if (s[i] == '"') {
+            put('"');
+         }
+         put(s[i]);
+      }
+      put('"');
+   }
+
+private:
+   static const size_t capacity = 1 << 20;
+   char* buffer;
+   size_t used = 0;
+};
+
+/** @brief Local wall time with ns, the date part is formatted once per second */
+class TimeFormat {
+public:
+   void put(Output& out, uint64_t ns) {
+      time_t seconds = ns / 1000000000;
+      if (seconds != second) {
+         struct tm t;
+         localtime_r(&seconds, &t);
+         size = strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S.", &t);
+         second = seconds;
+      }
+      out.put(stamp, size);
+      unsigned long fraction = ns % 1000000000;
+      char* p = out.reserve(9);
+      for (int i = 8; i >= 0; --i, fraction /= 10) {
+         p[i] = '0' + fraction % 10;
+      }
+      out.commit(9);
+   }
+
+private:
+   time_t second = -1;
+   char stamp[32];
+   size_t size = 0;
+};
+
+static void usage() {
+   cerr << "Usage: plcwatchd-log [-c] [-p plc] [-e event] [-s time] [-u time] directory|segment ..." << endl << endl
+         << "  -c   CSV instead of JSON lines" << endl
+         << "  -p   plc - only the events of this plc, may be given several times" << endl
+         << "  -e   event - only connect, status, push, receipt or hotstart events, may be given several times" << endl
+         << "  -s   time - only events from this local time on, e.g. \"2026-10-17 08:00:00\"" << endl
+         << "  -u   time - only events before this local time" << endl;
+}
+
+/** @brief Parse "YYYY-MM-DD HH:MM[:SS]" as local time
+ * @return ns since the epoch, 0 on error
+ */
+static uint64_t parse_time(const char* text) {
+   struct tm t;
+   memset(&t, 0, sizeof(t));
+   const char* end = strptime(text, "%Y-%m-%d %H:%M:%S", &t);
+   if (!end) {
+      memset(&t, 0, sizeof(t));
+      end = strptime(text, "%Y-%m-%d %H:%M", &t);
+   }
+   if (!end || *end) {
+      return 0;
+   }
+   t.tm_isdst = -1;
+   time_t seconds = mktime(&t);
+   return seconds < 0 ? 0 : (uint64_t) seconds * 1000000000ull;
+}
+
+static const char* status_name(int status) {
+   switch (status) {
+   case S7CpuStatusRun:
+      return "RUN";
+   case S7CpuStatusStop:
+      return "STOP";
+   default:
+      return "unknown";
+   }
+}
+
+int main(int argc, char *argv[]) {
+   bool csv = false;
+   set<string> plcs;
+   unsigned types = 0;  // bit per EventType, 0 for all
+   uint64_t from = 0;
+   uint64_t until = UINT64_MAX;
+   int option;
+   while ((option = getopt(argc, argv, "cp:e:s:u:")) != -1) {
+      switch (option) {
+      case 'c':
+         csv = true;
+         break;
+      case 'p':
+         plcs.insert(optarg);
+         break;
+      case 'e': {
+         unsigned type = EventConnect;
+         while (type <= EventHotStart && strcmp(optarg, eventNames[type])) {
+            ++type;
+         }
+         if (type > EventHotStart) {
+            usage();
+            return EXIT_FAILURE;
+         }
+         types |= 1u << type;
+         break;
+      }
+      case 's':
+      case 'u': {
+         uint64_t t = parse_time(optarg);
+         if (!t) {
+            usage();
+            return EXIT_FAILURE;
+         }
+         (option == 's' ? from : until) = t;
+         break;
+      }
+      default:
+         usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (optind >= argc) {
+      usage();
+      return EXIT_FAILURE;
+   }
+
+   vector<string> paths;
+   for (int i = optind; i < argc; ++i) {
+      struct stat st;
+      if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+         vector<string> segments = event_segments(argv[i]);
+         paths.insert(paths.end(), segments.begin(), segments.end());
+      } else {
+         paths.push_back(argv[i]);
+      }
+   }
+
+   Output out;
+   TimeFormat time;
+   if (csv) {
+      out.put("time,plc,event,state,value,detail,text\n");
+   }
+   int result = EXIT_SUCCESS;
+   for (const string& path : paths) {
+      EventReader reader;
+      string error;
+      if (!reader.open(path, error)) {
+         cerr << path << ": " << error << endl;
+         result = EXIT_FAILURE;
+         continue;
+      }
+      vector<string> names;     // by plc id, names are defined per segment
+      vector<bool> selected;
+      while (const EventRecord* r = reader.next()) {
+         if (r->type == EventPlc) {
+            if (r->plc >= names.size()) {
+               names.resize(r->plc + 1);
+               selected.resize(r->plc + 1);
+            }
+            names[r->plc].assign(r->text(), r->length);
+            selected[r->plc] = plcs.empty() || plcs.count(names[r->plc]);
+            continue;
+         }
+         if (r->type > EventHotStart || (types && !(types & (1u << r->type)))) {
+            continue;
+         }
+         if (r->plc >= names.size() ? !plcs.empty() : !selected[r->plc]) {
+            continue;
+         }
+         uint64_t wall = reader.realtime(*r);
+         if (wall < from || wall >= until) {
+            continue;
+         }
+         static const string none;
+         const string& name = r->plc < names.size() ? names[r->plc] : none;
+
+         if (csv) {
+            time.put(out, wall);
+            out.put(',');
+            out.csv(name.data(), name.size());
+            out.put(',');
+            out.name(eventNames[r->type]);
+            out.put(',');
+            switch (r->type) {
+            case EventConnect:
+               out.name(r->value ? "failed," : "ok,");
+               out.number(r->value);
+               out.put(',');
+               out.number(r->detail);
+               out.put(',');
+               break;
+            case EventStatus:
+               out.name(status_name(r->value));
+               out.put(',');
+               out.number(r->code);
+               out.put(",0x");
+               out.hex(r->detail, 4);
+               out.put(',');
+               break;
+            case EventPush:
+               out.put(',');
+               out.number(r->value);
+               out.put(",,");
+               out.csv(r->text(), r->length);
+               break;
+            case EventReceipt:
+               out.name(r->code < 5 ? receiptStates[r->code] : "");
+               out.put(',');
+               out.number(r->value);
+               out.put(",,");
+               out.csv(r->text(), r->length);
+               break;
+            case EventHotStart:
+               out.name(r->value ? "failed," : "ok,");
+               out.number(r->value);
+               out.put(",,");
+               break;
+            }
+            out.put('\n');
+            continue;
+         }
+
+         out.put("{\"time\":\"");
+         time.put(out, wall);
+         out.put("\",\"plc\":");
+         out.json(name.data(), name.size());
+         out.put(",\"event\":\"");
+         out.name(eventNames[r->type]);
+         out.put('"');
+         switch (r->type) {
+         case EventConnect:
+            out.put(",\"result\":");
+            out.number(r->value);
+            out.put(",\"latency_us\":");
+            out.number(r->detail);
+            break;
+         case EventStatus:
+            out.put(",\"status\":\"");
+            out.name(status_name(r->value));
+            out.put("\",\"previous\":");
+            out.number(r->code);
+            out.put(",\"transition\":\"0x");
+            out.hex(r->detail, 4);
+            out.put('"');
+            break;
+         case EventPush:
+            out.put(",\"priority\":");
+            out.number(r->value);
+            out.put(",\"title\":");
+            out.json(r->text(), r->length);
+            break;
+         case EventReceipt:
+            out.put(",\"state\":\"");
+            out.name(r->code < 5 ? receiptStates[r->code] : "");
+            out.put("\",\"receipt\":");
+            out.json(r->text(), r->length);
+            out.put(",\"http\":");
+            out.number(r->value);
+            break;
+         case EventHotStart:
+            out.put(",\"result\":");
+            out.number(r->value);
+            break;
+         }
+         out.put("}\n");
+      }
+   }
+   return result;
+}
@@ -0,0 +1,69 @@
+/*
+ * mpscqueue.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef POOL_MPSCQUEUE_H_
+#define POOL_MPSCQUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+/** @brief Unbounded lock-free queue, many producers and a single consumer
+ *
+ * push() is wait-free, a single atomic exchange. pop() must only be called by one thread at
+ * a time; it may miss an element whose push() is just in progress and returns it on the next
+ * call. T has to be default constructible.
+ */
+template<typename T> class MpscQueue {
+public:
+   MpscQueue() :
+         head(new Node), tail(head.load()) {
+   }
+   ~MpscQueue() {
+      T value;
+      while (pop(value)) {
+      }
+      delete tail;
+   }
+   MpscQueue(const MpscQueue&) = delete;
+   MpscQueue& operator=(const MpscQueue&) = delete;
+
+   /** @brief Append a value, from any thread */
+   void push(T value) {
+      Node* node = new Node;
+      node->value = std::move(value);
+      Node* prev = head.exchange(node, std::memory_order_acq_rel);
+      prev->next.store(node, std::memory_order_release);
+   }
+   /** @brief Take the oldest value, consumer thread only
+    * @return false if the queue is empty
+    */
+   bool pop(T& value) {
+      Node* next = tail->next.load(std::memory_order_acquire);
+      if (!next) {
+         return false;
+      }
+      value = std::move(next->value);
+      delete tail;
+      tail = next;
+      return true;
+   }
+   /** @brief Nothing queued, consumer thread only */
+   bool empty() const {
+      return !tail->next.load(std::memory_order_acquire);
+   }
+
+private:
+   struct Node {
+      std::atomic<Node*> next { nullptr };
+      T value;
+   };
+
+   std::atomic<Node*> head;  ///< last pushed node
+   Node* tail;               ///< consumed stub, its next is the oldest value
+};
+
+#endif /* POOL_MPSCQUEUE_H_ */
@@ -0,0 +1,122 @@
+/*
+ * threadpool.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include "threadpool.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// pool and worker index of the current thread, submit() from a worker queues locally
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+ThreadPool::ThreadPool(size_t count) :
+      statsStart(clock::now()) {
+   if (count == 0) {
+      count = 1;
+   }
+   for (size_t i = 0; i < count; ++i) {
+      workers.emplace_back(new Worker);
+   }
+   for (size_t i = 0; i < count; ++i) {
+      workers[i]->thread = thread(&ThreadPool::run, this, i);
+   }
+}
+
+ThreadPool::~ThreadPool() {
+   {
+      lock_guard<mutex> lock(sleepMutex);
+      running = false;
+   }
+   idle.notify_all();
+   for (auto& worker : workers) {
+      worker->thread.join();
+   }
+}
+
+void ThreadPool::submit(Task task) {
+   size_t index = (currentPool == this) ? currentWorker : next++ % workers.size();
+   {
+      // pending changes together with the deque, it never counts a task that is not queued
+      lock_guard<mutex> lock(workers[index]->mutex);
+      workers[index]->tasks.push_back(move(task));
+      ++pending;
+   }
+   {
+      // a worker checks pending under sleepMutex before it waits, so the notification is not lost
+      lock_guard<mutex> lock(sleepMutex);
+   }
+   idle.notify_one();
+}
+
+bool ThreadPool::pop(size_t index, Task& task) {
+   Worker& worker = *workers[index];
+   lock_guard<mutex> lock(worker.mutex);
+   if (worker.tasks.empty()) {
+      return false;
+   }
+   task = move(worker.tasks.back());
+   worker.tasks.pop_back();
+   --pending;
+   return true;
+}
+
+bool ThreadPool::steal(size_t index, Task& task) {
+   for (size_t i = 1; i < workers.size(); ++i) {
+      Worker& victim = *workers[(index + i) % workers.size()];
+      unique_lock<mutex> lock(victim.mutex, try_to_lock);
+      if (!lock.owns_lock() || victim.tasks.empty()) {
+         continue;
+      }
+      task = move(victim.tasks.front());
+      victim.tasks.pop_front();
+      --pending;
+      ++workers[index]->steals;
+      return true;
+   }
+   return false;
+}
+
+void ThreadPool::run(size_t index) {
+   currentPool = this;
+   currentWorker = index;
+   Worker& worker = *workers[index];
+
+   for (;;) {
+      Task task;
+      if (pop(index, task) || steal(index, task)) {
+         clock::time_point start = clock::now();
+         task();
+         worker.busyNs += duration_cast<nanoseconds>(clock::now() - start).count();
+         ++worker.executed;
+         continue;
+      }
+
+      unique_lock<mutex> lock(sleepMutex);
+      if (!running && pending == 0) {
+         return;
+      }
+      // a victim may have been locked during the steal attempt, retry without sleeping then
+      if (pending == 0) {
+         idle.wait(lock, [this] { return pending > 0 || !running; });
+      }
+   }
+}
+
+vector<ThreadPool::WorkerStats> ThreadPool::collect_stats() {
+   clock::time_point now = clock::now();
+   double wall = duration_cast<nanoseconds>(now - statsStart).count();
+   statsStart = now;
+
+   vector<WorkerStats> stats(workers.size());
+   for (size_t i = 0; i < workers.size(); ++i) {
+      stats[i].tasks = workers[i]->executed.exchange(0);
+      stats[i].steals = workers[i]->steals.exchange(0);
+      stats[i].utilisation = wall > 0 ? workers[i]->busyNs.exchange(0) / wall : 0;
+   }
+   return stats;
+}
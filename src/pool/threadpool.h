@@ -0,0 +1,79 @@
+/*
+ * threadpool.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef POOL_THREADPOOL_H_
+#define POOL_THREADPOOL_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** @brief Work-stealing thread pool
+ *
+ * Every worker owns a deque. Tasks submitted from a worker go to its own deque, tasks
+ * submitted from other threads are distributed round robin. A worker takes tasks from
+ * the back of its own deque and, once that is empty, steals from the front of the others,
+ * so a task blocking on an unreachable plc never holds up the tasks queued behind it.
+ */
+class ThreadPool {
+public:
+   typedef std::function<void()> Task;
+   typedef std::chrono::steady_clock clock;
+
+   /** @brief Counters of a worker since the last collect_stats() */
+   struct WorkerStats {
+      unsigned long tasks = 0;   ///< executed tasks
+      unsigned long steals = 0;  ///< tasks taken from other workers
+      double utilisation = 0;    ///< busy time / wall time, 0..1
+   };
+
+   /** @brief Start the workers
+    * @param workers number of threads, at least one
+    */
+   explicit ThreadPool(size_t workers);
+   /** @brief Run the queued tasks and join the workers */
+   ~ThreadPool();
+
+   ThreadPool(const ThreadPool&) = delete;
+   ThreadPool& operator=(const ThreadPool&) = delete;
+
+   /** @brief Queue a task */
+   void submit(Task task);
+   size_t size() const { return workers.size(); }
+   /** @brief Read and reset the worker counters */
+   std::vector<WorkerStats> collect_stats();
+
+private:
+   struct Worker {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+      std::thread thread;
+      std::atomic<unsigned long> executed { 0 };
+      std::atomic<unsigned long> steals { 0 };
+      std::atomic<long long> busyNs { 0 };
+   };
+
+   void run(size_t index);
+   bool pop(size_t index, Task& task);
+   bool steal(size_t index, Task& task);
+
+   std::vector<std::unique_ptr<Worker>> workers;
+   std::atomic<size_t> next { 0 };
+   std::atomic<size_t> pending { 0 };  ///< tasks in all deques, changed under the lock of the deque
+   std::mutex sleepMutex;
+   std::condition_variable idle;
+   bool running = true;
+   clock::time_point statsStart;
+};
+
+#endif /* POOL_THREADPOOL_H_ */
@@ -0,0 +1,121 @@
+/*
+ * timerwheel.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef POOL_TIMERWHEEL_H_
+#define POOL_TIMERWHEEL_H_
+
+#include <stdint.h>
+
+/** @brief Hierarchical timer wheel with intrusive timers
+ *
+ * Four levels of 64 slots cover 2^24 ticks, later deadlines are clamped. Scheduling and
+ * cancelling are O(1), a tick is O(1) amortized: a timer is moved down at most once per level
+ * before it fires. Not thread safe.
+ */
+class TimerWheel {
+public:
+   /** @brief Base of the objects to schedule */
+   struct Timer {
+      Timer* prev = nullptr;
+      Timer* next = nullptr;
+      uint64_t due = 0;  ///< tick to fire at
+      bool scheduled() const { return prev != nullptr; }
+   };
+
+   /** @param now first tick */
+   explicit TimerWheel(uint64_t now = 0) :
+         current(now) {
+      for (Timer (&level)[slots] : wheel) {
+         for (Timer& slot : level) {
+            slot.prev = slot.next = &slot;
+         }
+      }
+   }
+   TimerWheel(const TimerWheel&) = delete;
+   TimerWheel& operator=(const TimerWheel&) = delete;
+
+   /** @brief (Re)schedule a timer, a due tick already passed fires on the next tick */
+   void schedule(Timer& timer, uint64_t due) {
+      cancel(timer);
+      timer.due = due > current ? due : current + 1;
+      insert(timer, current + 1);
+   }
+   void cancel(Timer& timer) {
+      if (timer.scheduled()) {
+         timer.prev->next = timer.next;
+         timer.next->prev = timer.prev;
+         timer.prev = timer.next = nullptr;
+      }
+   }
+   /** @brief Run the ticks up to and including now
+    * @param fire called with every expired timer, which may be rescheduled from there
+    */
+   template<typename F> void advance(uint64_t now, F fire) {
+      while (current < now) {
+         uint64_t tick = ++current;
+         // move the timers of the next round down a level
+         for (int level = 1; level < levels && (tick >> ((level - 1) * bits) & (slots - 1)) == 0; ++level) {
+            cascade(wheel[level][tick >> (level * bits) & (slots - 1)], tick);
+         }
+         Timer& slot = wheel[0][tick & (slots - 1)];
+         while (slot.next != &slot) {
+            Timer* timer = slot.next;
+            cancel(*timer);
+            fire(*timer);
+         }
+      }
+   }
+   /** @brief Jump to tick now without running the ticks in between, no timer may be scheduled */
+   void rebase(uint64_t now) {
+      current = now;
+   }
+   /** @brief Last tick run */
+   uint64_t now() const { return current; }
+
+private:
+   static const int bits = 6;
+   static const int slots = 1 << bits;
+   static const int levels = 4;
+
+   void insert(Timer& timer, uint64_t base) {
+      uint64_t delta = timer.due - base;
+      int level = 0;
+      while (level < levels - 1 && delta >= (uint64_t) 1 << ((level + 1) * bits)) {
+         ++level;
+      }
+      if (delta >= (uint64_t) 1 << (levels * bits)) {
+         timer.due = base + ((uint64_t) 1 << (levels * bits)) - 1;
+      }
+      Timer& slot = wheel[level][timer.due >> (level * bits) & (slots - 1)];
+      timer.prev = slot.prev;
+      timer.next = &slot;
+      slot.prev->next = &timer;
+      slot.prev = &timer;
+   }
+   void cascade(Timer& slot, uint64_t tick) {
+      Timer list;
+      list.prev = list.next = &list;
+      if (slot.next != &slot) {
+         // take the whole list, then spread it relative to tick
+         list.next = slot.next;
+         list.prev = slot.prev;
+         list.next->prev = list.prev->next = &list;
+         slot.prev = slot.next = &slot;
+      }
+      while (list.next != &list) {
+         Timer* timer = list.next;
+         list.next = timer->next;
+         timer->next->prev = &list;
+         insert(*timer, tick);
+      }
+   }
+
+   Timer wheel[levels][slots];
+   uint64_t current;
+};
+
+#endif /* POOL_TIMERWHEEL_H_ */
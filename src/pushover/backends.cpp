@@ -0,0 +1,215 @@
+/*
+ * backends.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "backends.h"
+#include "log.hpp"
+
+using namespace std;
+
+static void done_with(const PushoverCallback& done, bool ok) {
+   if (done) {
+      PushoverResult result;
+      result.ok = ok;
+      result.status = ok;
+      done(result);
+   }
+}
+
+void PushoverNotifier::send(const Notification& n, PushoverCallback done) {
+   outbox.push_emergency(n.source, n.title.c_str(), n.message.c_str(), n.priority.c_str(), n.retry.c_str(),
+         n.expire.c_str(), n.key.c_str(), n.token.c_str(), n.device.empty() ? NULL : n.device.c_str(),
+         n.callback.empty() ? NULL : n.callback.c_str(), move(done));
+}
+
+/* a webhook answers within the limits of the pushover.net client or counts as failed */
+static const long webhookConnectTimeout = 10;
+static const long webhookTimeout = 30;
+/* transfers to the hook at once, the others wait in order */
+static const int webhookTransfers = 4;
+
+/** @brief A queued or running POST, owned by the dispatcher once queued */
+struct WebhookNotifier::Post {
+   string json;
+   PushoverCallback done;
+};
+
+WebhookNotifier::WebhookNotifier(const string& url) :
+      url(url), multi(curl_multi_init()), headers(curl_slist_append(NULL, "Content-Type: application/json")) {
+   dispatcher = thread(&WebhookNotifier::run, this);
+}
+
+WebhookNotifier::~WebhookNotifier() {
+   running = false;
+   curl_multi_wakeup(multi);
+   dispatcher.join();
+   curl_multi_cleanup(multi);
+   curl_slist_free_all(headers);
+}
+
+void WebhookNotifier::send(const Notification& notification, PushoverCallback done) {
+   queue.push(unique_ptr<Post>(new Post { to_json(notification), move(done) }));
+   curl_multi_wakeup(multi);
+}
+
+/** @brief Dispatcher thread, runs the transfers until destruction and the queue is drained */
+void WebhookNotifier::run() {
+   int transfers = 0;
+   for (;;) {
+      unique_ptr<Post> post;
+      while (queue.pop(post)) {
+         waiting.push_back(move(post));
+      }
+      while (active < webhookTransfers && !waiting.empty()) {
+         post = move(waiting.front());
+         waiting.pop_front();
+         start(move(post));
+      }
+      curl_multi_perform(multi, &transfers);
+
+      int pending;
+      while (CURLMsg* msg = curl_multi_info_read(multi, &pending)) {
+         if (msg->msg == CURLMSG_DONE) {
+            finish(msg->easy_handle, msg->data.result);
+         }
+      }
+      if (!running && transfers == 0 && waiting.empty() && queue.empty()) {
+         break;
+      }
+      curl_multi_poll(multi, NULL, 0, active < webhookTransfers && !waiting.empty() ? 0 : 1000, NULL);
+   }
+}
+
+void WebhookNotifier::start(unique_ptr<Post> post) {
+   CURL* curl = curl_easy_init();
+   if (!curl) {
+      tcerr() << "webhook: curl_easy_init() failed" << endl;
+      done_with(post->done, false);
+      return;
+   }
+   curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+   curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post->json.c_str());
+   curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+   curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, webhookConnectTimeout);
+   curl_easy_setopt(curl, CURLOPT_TIMEOUT, webhookTimeout);
+   curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+   curl_easy_setopt(curl, CURLOPT_PRIVATE, post.release());
+   curl_multi_add_handle(multi, curl);
+   ++active;
+}
+
+void WebhookNotifier::finish(CURL* curl, CURLcode res) {
+   Post* raw = NULL;
+   curl_easy_getinfo(curl, CURLINFO_PRIVATE, &raw);
+   unique_ptr<Post> post(raw);
+   long code = 0;
+   curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+   curl_multi_remove_handle(multi, curl);
+   curl_easy_cleanup(curl);
+   --active;
+
+   // any server, only the status counts
+   bool ok = res == CURLE_OK && code >= 200 && code < 300;
+   if (res != CURLE_OK) {
+      tcerr() << "webhook: curl failed: " << curl_easy_strerror(res) << endl;
+   } else if (!ok) {
+      tcerr() << "webhook: " << url << " answered HTTP " << code << endl;
+   }
+   if (post->done) {
+      PushoverResult result;
+      result.http = (int) code;
+      result.ok = ok;
+      result.status = ok;
+      post->done(result);
+   }
+}
+
+SyslogNotifier::SyslogNotifier(const string& ident) :
+      ident(ident) {
+   openlog(this->ident.c_str(), LOG_PID, LOG_DAEMON);
+}
+
+SyslogNotifier::~SyslogNotifier() {
+   closelog();
+}
+
+void SyslogNotifier::send(const Notification& n, PushoverCallback done) {
+   int priority = atoi(n.priority.c_str());
+   int level = priority >= 2 ? LOG_ALERT : priority == 1 ? LOG_ERR : priority == 0 ? LOG_NOTICE
+         : priority == -1 ? LOG_INFO : LOG_DEBUG;
+   syslog(level, "%s: %s", n.title.c_str(), n.message.c_str());
+   done_with(done, true);
+}
+
+SocketNotifier::SocketNotifier(const string& path) :
+      path(path), fd(socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0)) {
+}
+
+SocketNotifier::~SocketNotifier() {
+   if (fd >= 0) {
+      close(fd);
+   }
+}
+
+void SocketNotifier::send(const Notification& notification, PushoverCallback done) {
+   struct sockaddr_un addr = {};
+   addr.sun_family = AF_UNIX;
+   strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+   // nobody listening is a failure of this notification, never a reason to wait
+   string json = to_json(notification) + "\n";
+   ssize_t n = fd < 0 ? -1 : sendto(fd, json.data(), json.size(), MSG_DONTWAIT | MSG_NOSIGNAL,
+         (struct sockaddr*) &addr, sizeof(addr));
+   done_with(done, n == (ssize_t) json.size());
+}
+
+static void put_json(string& out, const char* key, const string& value) {
+   out += out.size() > 1 ? ",\"" : "\"";
+   out += key;
+   out += "\":\"";
+   for (char c : value) {
+      if (c == '"' || c == '\\') {
+         out += '\\';
+         out += c;
+      } else if ((unsigned char) c < 0x20) {
+         char escaped[8];
+         snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+         out += escaped;
+      } else {
+         out += c;
+      }
+   }
+   out += '"';
+}
+
+string to_json(const Notification& n) {
+   string out = "{";
+   put_json(out, "source", n.source);
+   put_json(out, "title", n.title);
+   put_json(out, "message", n.message);
+   out += ",\"priority\":" + to_string(atoi(n.priority.c_str())) + "}";
+   return out;
+}
+
+unique_ptr<Notifier> create_notifier(const string& spec) {
+   size_t colon = spec.find(':');
+   string kind = spec.substr(0, colon);
+   string target = colon == string::npos ? string() : spec.substr(colon + 1);
+   if (kind == "webhook" && !target.empty()) {
+      return unique_ptr<Notifier>(new WebhookNotifier(target));
+   } else if (kind == "syslog") {
+      return unique_ptr<Notifier>(new SyslogNotifier(target.empty() ? "plcwatchd" : target));
+   } else if (kind == "socket" && !target.empty() && target.size() < sizeof(sockaddr_un::sun_path)) {
+      return unique_ptr<Notifier>(new SocketNotifier(target));
+   }
+   return nullptr;
+}
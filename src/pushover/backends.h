@@ -0,0 +1,98 @@
+/*
+ * backends.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PUSHOVER_BACKENDS_H_
+#define PUSHOVER_BACKENDS_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <curl/curl.h>
+#include "mpscqueue.h"
+#include "notifier.h"
+#include "outbox.h"
+
+/** @brief pushover.net via the outbox, the only backend reporting receipts */
+class PushoverNotifier: public Notifier {
+public:
+   explicit PushoverNotifier(Outbox& outbox) :
+         outbox(outbox) {
+   }
+   const char* name() const override { return "pushover"; }
+   void send(const Notification& notification, PushoverCallback done) override;
+private:
+   Outbox& outbox;
+};
+
+/** @brief POSTs every notification as JSON document to a URL
+ *
+ * A dispatcher thread of its own runs the transfers on a curl multi handle, a slow hook does not
+ * hold up pushover.net. None of the quota or priority handling of the pushover.net client applies,
+ * only the HTTP status of the answer counts.
+ */
+class WebhookNotifier: public Notifier {
+public:
+   explicit WebhookNotifier(const std::string& url);
+   /** @brief Finish the queued and running transfers */
+   ~WebhookNotifier();
+   WebhookNotifier(const WebhookNotifier&) = delete;
+   WebhookNotifier& operator=(const WebhookNotifier&) = delete;
+
+   const char* name() const override { return "webhook"; }
+   void send(const Notification& notification, PushoverCallback done) override;
+private:
+   struct Post;
+
+   void run();
+   void start(std::unique_ptr<Post> post);
+   void finish(CURL* curl, CURLcode res);
+
+   std::string url;
+   CURLM* multi;
+   curl_slist* headers;
+   MpscQueue<std::unique_ptr<Post>> queue;
+   std::deque<std::unique_ptr<Post>> waiting;  ///< dispatcher thread only
+   int active = 0;                             ///< transfers running, dispatcher thread only
+   std::atomic<bool> running { true };
+   std::thread dispatcher;
+};
+
+/** @brief Logs every notification to syslog, the priority maps to the level */
+class SyslogNotifier: public Notifier {
+public:
+   explicit SyslogNotifier(const std::string& ident);
+   ~SyslogNotifier();
+   const char* name() const override { return "syslog"; }
+   void send(const Notification& notification, PushoverCallback done) override;
+private:
+   std::string ident;  ///< openlog() keeps the pointer
+};
+
+/** @brief Sends every notification as JSON datagram to a local unix socket */
+class SocketNotifier: public Notifier {
+public:
+   explicit SocketNotifier(const std::string& path);
+   ~SocketNotifier();
+   const char* name() const override { return "socket"; }
+   void send(const Notification& notification, PushoverCallback done) override;
+private:
+   std::string path;
+   int fd;
+};
+
+/** @brief Notification as JSON object */
+std::string to_json(const Notification& notification);
+
+/** @brief Create a backend from its description
+ * @param spec "webhook:<url>", "syslog[:<ident>]" or "socket:<path>"
+ * @return NULL if spec is invalid
+ */
+std::unique_ptr<Notifier> create_notifier(const std::string& spec);
+
+#endif /* PUSHOVER_BACKENDS_H_ */
@@ -0,0 +1,183 @@
+/*
+ * callback.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <iostream>
+#include "callback.h"
+#include "http.h"
+#include "log.hpp"
+
+using namespace std;
+
+// requests are tiny, anything larger is not from pushover.net
+static const size_t maxRequest = 8192;
+static const size_t maxClients = 64;
+static const chrono::seconds clientTimeout(5);
+
+CallbackServer::CallbackServer(ReceiptTracker& receipts) :
+      receipts(receipts) {
+}
+
+CallbackServer::~CallbackServer() {
+   if (thread.joinable()) {
+      uint64_t one = 1;
+      [[maybe_unused]] auto n = write(stopFd, &one, sizeof(one));
+      thread.join();
+   }
+   for (Client& client : clients) {
+      close(client.fd);
+   }
+   if (listenFd >= 0) {
+      close(listenFd);
+   }
+   if (stopFd >= 0) {
+      close(stopFd);
+   }
+}
+
+bool CallbackServer::listen(const string& address) {
+   struct sockaddr_in addr = {};
+   addr.sin_family = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_ANY);
+   string port = address;
+   size_t colon = address.rfind(':');
+   if (colon != string::npos) {
+      port = address.substr(colon + 1);
+      if (inet_pton(AF_INET, address.substr(0, colon).c_str(), &addr.sin_addr) != 1) {
+         tcerr() << "Callback: invalid address '" << address << "'" << endl;
+         return false;
+      }
+   }
+   char* end = NULL;
+   long number = strtol(port.c_str(), &end, 10);
+   if (port.empty() || *end || number <= 0 || number > 65535) {
+      tcerr() << "Callback: invalid port '" << address << "'" << endl;
+      return false;
+   }
+   addr.sin_port = htons((uint16_t) number);
+
+   listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+   stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   int on = 1;
+   if (listenFd < 0 || stopFd < 0 || setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0
+         || bind(listenFd, (struct sockaddr*) &addr, sizeof(addr)) < 0 || ::listen(listenFd, 16) < 0) {
+      tcerr() << "Callback: unable to listen on " << address << ": " << strerror(errno) << endl;
+      return false;
+   }
+   tcout() << "Callback: listening on " << address << endl;
+   thread = std::thread(&CallbackServer::run, this);
+   return true;
+}
+
+/** @brief Listener thread, accepts and serves the connections until destruction */
+void CallbackServer::run() {
+   vector<struct pollfd> fds;
+   for (;;) {
+      fds.clear();
+      fds.push_back( { stopFd, POLLIN, 0 });
+      fds.push_back( { listenFd, (short) (clients.size() < maxClients ? POLLIN : 0), 0 });
+      for (const Client& client : clients) {
+         fds.push_back( { client.fd, POLLIN, 0 });
+      }
+      if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) {
+         tcerr() << "Callback: poll failed: " << strerror(errno) << endl;
+         return;
+      }
+      if (fds[0].revents) {
+         return;
+      }
+
+      // serve or drop the connections, fds[i + 2] belongs to clients[i]
+      clock::time_point now = clock::now();
+      size_t kept = 0;
+      for (size_t i = 0; i < clients.size(); ++i) {
+         Client& client = clients[i];
+         bool open = true;
+         if (fds[i + 2].revents) {
+            open = receive(client);
+         } else if (now - client.since > clientTimeout) {
+            open = false;
+         }
+         if (open) {
+            clients[kept++] = client;
+         } else {
+            close(client.fd);
+         }
+      }
+      clients.resize(kept);
+
+      if (fds[1].revents & POLLIN) {
+         int fd;
+         while (clients.size() < maxClients
+               && (fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            clients.push_back(Client { fd, string(), now });
+         }
+      }
+   }
+}
+
+/** @brief Read from a connection and answer once the request is complete
+ * @return false if the connection is to be closed
+ */
+bool CallbackServer::receive(Client& client) {
+   char buffer[2048];
+   ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+   if (n < 0) {
+      return errno == EAGAIN || errno == EINTR;
+   }
+   if (n == 0) {
+      return false;
+   }
+   client.request.append(buffer, n);
+
+   http::Request request;
+   switch (http::parse(client.request, request, maxRequest)) {
+   case http::Incomplete:
+      return true;
+   case http::TooLarge:
+      respond(client.fd, 413);
+      return false;
+   case http::Invalid:
+      respond(client.fd, 400);
+      return false;
+   default:
+      respond(client.fd, handle(request));
+      return false;
+   }
+}
+
+/** @brief Evaluate a complete request
+ * @return HTTP status of the answer
+ */
+int CallbackServer::handle(const http::Request& request) {
+   if (request.method != "POST") {
+      return 405;
+   }
+   string receipt = http::form_field(request.body, "receipt");
+   if (receipt.empty() || http::form_field(request.body, "acknowledged") != "1") {
+      return 400;
+   }
+   if (!receipts.acknowledge(receipt)) {
+      tcout() << "Callback: unknown receipt " << receipt << endl;
+      return 404;
+   }
+   tcout() << "Callback: emergency " << receipt << " acknowledged" << endl;
+   return 200;
+}
+
+void CallbackServer::respond(int fd, int status) {
+   string response = http::response(status, string(), false);
+   (void) send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+}
@@ -0,0 +1,64 @@
+/*
+ * callback.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PUSHOVER_CALLBACK_H_
+#define PUSHOVER_CALLBACK_H_
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "http.h"
+#include "receipts.h"
+
+/** @brief Receiver of the pushover.net acknowledgement callbacks
+ *
+ * A minimal HTTP/1.1 listener on its own thread. pushover.net POSTs the form fields receipt
+ * and acknowledged=1 to the callback URL of an emergency once it is acknowledged, the receipt
+ * is then handed to the ReceiptTracker at once. Test it locally with
+ * @code
+ * curl -d receipt=<receipt> -d acknowledged=1 http://localhost:<port>/
+ * @endcode
+ * Unknown receipts are answered with 404. The receipt is the only secret, so only forward
+ * the port to this listener.
+ */
+class CallbackServer {
+public:
+   explicit CallbackServer(ReceiptTracker& receipts);
+   /** @brief Close the listener and all connections */
+   ~CallbackServer();
+   CallbackServer(const CallbackServer&) = delete;
+   CallbackServer& operator=(const CallbackServer&) = delete;
+
+   /** @brief Start listening
+    * @param address "port" or "ipv4-address:port"
+    * @return false if the address is invalid or the port is in use, the error is logged
+    */
+   bool listen(const std::string& address);
+
+private:
+   typedef std::chrono::steady_clock clock;
+
+   struct Client {
+      int fd;
+      std::string request;
+      clock::time_point since;
+   };
+
+   void run();
+   bool receive(Client& client);
+   int handle(const http::Request& request);
+   void respond(int fd, int status);
+
+   ReceiptTracker& receipts;
+   int listenFd = -1;
+   int stopFd = -1;  ///< eventfd ending the listener thread
+   std::vector<Client> clients;
+   std::thread thread;
+};
+
+#endif /* PUSHOVER_CALLBACK_H_ */
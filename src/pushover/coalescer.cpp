@@ -0,0 +1,123 @@
+/*
+ * coalescer.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+#include "coalescer.h"
+#include "log.hpp"
+
+using namespace std;
+
+/* pushover.net accepts messages up to 1024 characters, leave room for the text */
+static const size_t maxSources = 768;
+
+Coalescer::Coalescer(Notifier& notifier, clock::duration window) :
+      notifier(notifier), window(window), thread(&Coalescer::run, this) {
+}
+
+Coalescer::~Coalescer() {
+   stop();
+}
+
+void Coalescer::stop() {
+   {
+      lock_guard<std::mutex> lock(mutex);
+      running = false;
+      wake.notify_all();
+   }
+   if (thread.joinable()) {
+      thread.join();
+   }
+}
+
+void Coalescer::push(const string& source, const char* title, const char* message, const char* priority,
+      const char* retry, const char* expire, const char* key, const char* token, const char* device) {
+   ++total;
+   Group notification { title, message, priority, retry, expire, key, token, device ? device : "",
+         { source }, clock::now() + window };
+   // emergencies must not wait, the user has to react to each of them
+   if (window == clock::duration::zero() || !strcmp(priority, "2")) {
+      send(notification);
+      return;
+   }
+
+   string kind = notification.title + '\n' + notification.message + '\n' + notification.priority + '\n'
+         + notification.key + '\n' + notification.token + '\n' + (device ? device : "\n");
+   unique_lock<std::mutex> lock(mutex);
+   if (!running) {
+      lock.unlock();
+      send(notification);
+      return;
+   }
+   auto it = groups.find(kind);
+   if (it == groups.end()) {
+      groups.emplace(move(kind), move(notification));
+      wake.notify_all();
+   } else if (find(it->second.sources.begin(), it->second.sources.end(), source) == it->second.sources.end()) {
+      it->second.sources.push_back(source);
+   }
+}
+
+/** @brief Coalescer thread, sends every group once its window elapsed */
+void Coalescer::run() {
+   unique_lock<std::mutex> lock(mutex);
+   for (;;) {
+      clock::time_point now = clock::now();
+      vector<Group> due;
+      for (auto it = groups.begin(); it != groups.end();) {
+         if (!running || it->second.due <= now) {
+            due.push_back(move(it->second));
+            it = groups.erase(it);
+         } else {
+            ++it;
+         }
+      }
+      if (!due.empty()) {
+         lock.unlock();
+         for (const Group& group : due) {
+            send(group);
+         }
+         lock.lock();
+         continue;
+      }
+      if (!running) {
+         break;
+      }
+      if (groups.empty()) {
+         wake.wait(lock);
+      } else {
+         clock::time_point next = clock::time_point::max();
+         for (const auto& group : groups) {
+            next = min(next, group.second.due);
+         }
+         wake.wait_until(lock, next);
+      }
+   }
+}
+
+/** @brief Send a group as single message, the affected plcs are listed in front of the text */
+void Coalescer::send(const Group& group) {
+   string sources;
+   size_t listed = 0;
+   for (const string& source : group.sources) {
+      if (source.empty() || sources.size() + source.size() > maxSources) {
+         continue;
+      }
+      sources += (listed++ ? ", " : "") + source;
+   }
+   if (listed < group.sources.size() && !sources.empty()) {
+      sources += " and " + to_string(group.sources.size() - listed) + " more";
+   }
+   if (group.sources.size() > 1) {
+      tcout() << "Coalesced " << group.sources.size() << " notifications: " << group.title << endl;
+   }
+   ++messages;
+   notifier.send(Notification { group.sources.size() == 1 ? group.sources.front() : string(), group.title,
+         sources.empty() ? group.message : sources + ": " + group.message, group.priority, group.retry, group.expire,
+         group.key, group.token, group.device, string() }, nullptr);
+}
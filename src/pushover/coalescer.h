@@ -0,0 +1,74 @@
+/*
+ * coalescer.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PUSHOVER_COALESCER_H_
+#define PUSHOVER_COALESCER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "notifier.h"
+
+/** @brief Merges the notifications of an alert storm into digests
+ *
+ * A notification opens a group of its kind (same title, message, priority and recipients) which
+ * collects the notifications of the other plcs for a short window. Then a single message listing
+ * all affected plcs is sent, e.g. "hall, garage, lab: S7 connection failed" once a switch rebooted.
+ * Emergencies (priority 2) are passed on at once.
+ */
+class Coalescer {
+public:
+   typedef std::chrono::steady_clock clock;
+
+   /** @param window time a group collects notifications, zero passes everything at once */
+   Coalescer(Notifier& notifier, clock::duration window);
+   /** @brief Send the pending digests right away */
+   ~Coalescer();
+   Coalescer(const Coalescer&) = delete;
+   Coalescer& operator=(const Coalescer&) = delete;
+
+   /** @brief Queue a notification, the parameters are the ones of Pushover::push_emergency()
+    * @param source name of the plc listed in the digest, empty if there is a single plc
+    */
+   void push(const std::string& source, const char* title, const char* message, const char* priority,
+         const char* retry, const char* expire, const char* key, const char* token, const char* device);
+
+   /** @brief Send the pending digests right away, later notifications are passed on at once */
+   void stop();
+
+   /** @brief Notifications queued */
+   size_t received() const { return total; }
+   /** @brief Messages sent to the client */
+   size_t sent() const { return messages; }
+
+private:
+   struct Group {
+      std::string title, message, priority, retry, expire, key, token, device;  ///< device empty for all
+      std::vector<std::string> sources;
+      clock::time_point due;
+   };
+
+   void run();
+   void send(const Group& group);
+
+   Notifier& notifier;
+   const clock::duration window;
+   std::mutex mutex;
+   std::condition_variable wake;
+   std::map<std::string, Group> groups;  ///< open groups by kind and recipients
+   std::atomic<size_t> total { 0 };
+   std::atomic<size_t> messages { 0 };
+   bool running = true;
+   std::thread thread;
+};
+
+#endif /* PUSHOVER_COALESCER_H_ */
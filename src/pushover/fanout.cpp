@@ -0,0 +1,125 @@
+/*
+ * fanout.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <iostream>
+#include "fanout.h"
+#include "log.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+/* a backend this far behind is stuck, its oldest notifications are dropped */
+static const size_t maxQueued = 1024;
+
+FanOut::FanOut() {
+}
+
+FanOut::~FanOut() {
+   for (auto& lane : lanes) {
+      {
+         lock_guard<std::mutex> lock(lane->mutex);
+         lane->running = false;
+      }
+      lane->wake.notify_all();
+   }
+   for (auto& lane : lanes) {
+      lane->thread.join();
+   }
+}
+
+void FanOut::add(unique_ptr<Notifier> backend) {
+   lanes.emplace_back(new Lane);
+   Lane& lane = *lanes.back();
+   lane.backend = move(backend);
+   lane.counters = make_shared<Counters>();
+   lane.thread = thread(&FanOut::run, this, ref(lane));
+}
+
+void FanOut::send(const Notification& notification, PushoverCallback done) {
+   clock::time_point now = clock::now();
+   if (lanes.empty() && done) {
+      done(PushoverResult());
+   }
+   for (size_t i = 0; i < lanes.size(); ++i) {
+      Lane& lane = *lanes[i];
+      Item dropped;
+      {
+         lock_guard<std::mutex> lock(lane.mutex);
+         if (lane.queue.size() >= maxQueued) {
+            dropped = move(lane.queue.front());
+            lane.queue.pop_front();
+            ++lane.counters->dropped;
+         }
+         lane.queue.push_back(Item { notification, i == 0 ? done : nullptr, now });
+      }
+      lane.wake.notify_one();
+      if (dropped.done) {
+         PushoverResult result;
+         result.dropped = true;
+         dropped.done(result);
+      }
+   }
+}
+
+/** @brief Lane thread, hands the notifications to its backend one by one */
+void FanOut::run(Lane& lane) {
+   unique_lock<std::mutex> lock(lane.mutex);
+   for (;;) {
+      lane.wake.wait(lock, [&lane] {return !lane.running || !lane.queue.empty();});
+      if (lane.queue.empty()) {
+         break;
+      }
+      Item item = move(lane.queue.front());
+      lane.queue.pop_front();
+      lane.busy = true;
+      lock.unlock();
+
+      shared_ptr<Counters> counters = lane.counters;
+      clock::time_point queued = item.queued;
+      PushoverCallback done = move(item.done);
+      lane.backend->send(item.notification, [counters, queued, done](const PushoverResult& result) {
+         long long ns = duration_cast<nanoseconds>(clock::now() - queued).count();
+         ++(result.ok && result.status == 1 ? counters->sent : counters->failed);
+         counters->latencyNs += ns;
+         long long max = counters->maxNs;
+         while (ns > max && !counters->maxNs.compare_exchange_weak(max, ns)) {
+         }
+         if (done) {
+            done(result);
+         }
+      });
+      lock.lock();
+      lane.busy = false;
+      lane.wake.notify_all();
+   }
+}
+
+size_t FanOut::drain(clock::time_point deadline) {
+   size_t queued = 0;
+   for (auto& lane : lanes) {
+      unique_lock<std::mutex> lock(lane->mutex);
+      lane->wake.wait_until(lock, deadline, [&lane] {return lane->queue.empty() && !lane->busy;});
+      queued += lane->queue.size();
+   }
+   return queued;
+}
+
+vector<FanOut::Stats> FanOut::collect_stats() {
+   vector<Stats> stats(lanes.size());
+   for (size_t i = 0; i < lanes.size(); ++i) {
+      Counters& c = *lanes[i]->counters;
+      stats[i].name = lanes[i]->backend->name();
+      stats[i].sent = c.sent.exchange(0);
+      stats[i].failed = c.failed.exchange(0);
+      stats[i].dropped = c.dropped.exchange(0);
+      unsigned long count = stats[i].sent + stats[i].failed;
+      long long latency = c.latencyNs.exchange(0);
+      stats[i].average = count ? duration_cast<clock::duration>(nanoseconds(latency / count)) : clock::duration::zero();
+      stats[i].max = duration_cast<clock::duration>(nanoseconds(c.maxNs.exchange(0)));
+   }
+   return stats;
+}
@@ -0,0 +1,94 @@
+/*
+ * fanout.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PUSHOVER_FANOUT_H_
+#define PUSHOVER_FANOUT_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "notifier.h"
+
+/** @brief Delivers every notification to all backends in parallel
+ *
+ * Each backend has a lane of its own, a queue and a thread calling its send(), so a slow or
+ * blocking backend never delays the others. A lane keeping up with nothing drops its oldest
+ * notifications. The outcome of the first backend (pushover.net) is reported to the caller,
+ * the others only count.
+ */
+class FanOut: public Notifier {
+public:
+   typedef std::chrono::steady_clock clock;
+
+   /** @brief Counters of a backend since the last collect_stats() */
+   struct Stats {
+      std::string name;
+      unsigned long sent = 0;
+      unsigned long failed = 0;
+      unsigned long dropped = 0;    ///< lane overflowed
+      clock::duration average = clock::duration::zero(); ///< queued until done
+      clock::duration max = clock::duration::zero();
+   };
+
+   FanOut();
+   /** @brief Hand the queued notifications to the backends and stop the lanes */
+   ~FanOut();
+   FanOut(const FanOut&) = delete;
+   FanOut& operator=(const FanOut&) = delete;
+
+   /** @brief Add a backend before the first notification, the first one added is the primary one */
+   void add(std::unique_ptr<Notifier> backend);
+   size_t size() const { return lanes.size(); }
+
+   const char* name() const override { return "fan-out"; }
+   /** @param done receives the outcome of the primary backend */
+   void send(const Notification& notification, PushoverCallback done) override;
+
+   /** @brief Wait until every backend took its queued notifications or deadline passed
+    * @return notifications still queued
+    */
+   size_t drain(clock::time_point deadline);
+
+   /** @brief Read and reset the counters of the backends */
+   std::vector<Stats> collect_stats();
+
+private:
+   struct Counters {
+      std::atomic<unsigned long> sent { 0 };
+      std::atomic<unsigned long> failed { 0 };
+      std::atomic<unsigned long> dropped { 0 };
+      std::atomic<long long> latencyNs { 0 };
+      std::atomic<long long> maxNs { 0 };
+   };
+   struct Item {
+      Notification notification;
+      PushoverCallback done;
+      clock::time_point queued;
+   };
+   struct Lane {
+      std::unique_ptr<Notifier> backend;
+      std::shared_ptr<Counters> counters;  ///< shared with the callbacks of the backend
+      std::mutex mutex;
+      std::condition_variable wake;
+      std::deque<Item> queue;
+      bool running = true;
+      bool busy = false;     ///< a notification is handed to the backend
+      std::thread thread;
+   };
+
+   void run(Lane& lane);
+
+   std::vector<std::unique_ptr<Lane>> lanes;
+};
+
+#endif /* PUSHOVER_FANOUT_H_ */
@@ -0,0 +1,115 @@
+/*
+ * http.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "http.h"
+
+using namespace std;
+
+namespace http {
+
+Parse parse(string& buffer, Request& request, size_t maxSize) {
+   size_t header = buffer.find("\r\n\r\n");
+   if (header == string::npos) {
+      return buffer.size() > maxSize ? TooLarge : Incomplete;
+   }
+   size_t length = 0;
+   bool close = false;
+   size_t line = buffer.find("\r\n");
+   for (size_t pos = line; pos < header;) {
+      size_t next = buffer.find("\r\n", pos + 2);
+      const char* field = buffer.c_str() + pos + 2;
+      if (strncasecmp(field, "Content-Length:", 15) == 0) {
+         // digits only, checked against the limit before it is added to any offset
+         const char* value = field + 15 + strspn(field + 15, " \t");
+         if (!isdigit((unsigned char) *value)) {
+            return Invalid;
+         }
+         char* end;
+         errno = 0;
+         unsigned long long n = strtoull(value, &end, 10);
+         if (errno == ERANGE || end[strspn(end, " \t")] != '\r') {
+            return Invalid;
+         }
+         if (header + 4 > maxSize || n > maxSize - (header + 4)) {
+            return TooLarge;
+         }
+         length = n;
+      } else if (strncasecmp(field, "Connection:", 11) == 0) {
+         close = strncasecmp(field + 11 + strspn(field + 11, " "), "close", 5) == 0;
+      }
+      pos = next;
+   }
+   if (header + 4 + length > maxSize) {
+      return TooLarge;
+   }
+   if (buffer.size() < header + 4 + length) {
+      return Incomplete;
+   }
+
+   // request line: method target version
+   size_t sp1 = buffer.find(' ');
+   size_t sp2 = sp1 < line ? buffer.find(' ', sp1 + 1) : string::npos;
+   request.method = buffer.substr(0, min(sp1, line));
+   request.target = sp2 < line ? buffer.substr(sp1 + 1, sp2 - sp1 - 1) : string();
+   request.body = buffer.substr(header + 4, length);
+   request.keepAlive = !close && !(sp2 < line && buffer.compare(sp2 + 1, 8, "HTTP/1.0") == 0);
+   buffer.erase(0, header + 4 + length);
+   return Complete;
+}
+
+string url_decode(const string& value) {
+   string out;
+   out.reserve(value.size());
+   for (size_t i = 0; i < value.size(); ++i) {
+      if (value[i] == '+') {
+         out += ' ';
+      } else if (value[i] == '%' && i + 2 < value.size() && isxdigit((unsigned char) value[i + 1])
+            && isxdigit((unsigned char) value[i + 2])) {
+         out += (char) strtol(value.substr(i + 1, 2).c_str(), NULL, 16);
+         i += 2;
+      } else {
+         out += value[i];
+      }
+   }
+   return out;
+}
+
+string form_field(const string& form, const char* name) {
+   size_t len = strlen(name);
+   size_t pos = 0;
+   while (pos <= form.size()) {
+      size_t end = form.find('&', pos);
+      if (end == string::npos) {
+         end = form.size();
+      }
+      if (end - pos > len && form.compare(pos, len, name) == 0 && form[pos + len] == '=') {
+         return url_decode(form.substr(pos + len + 1, end - pos - len - 1));
+      }
+      pos = end + 1;
+   }
+   return string();
+}
+
+string response(int status, const string& body, bool keepAlive, const string& headers) {
+   const char* reason = status == 200 ? "OK" : status == 400 ? "Bad Request" : status == 404 ? "Not Found"
+         : status == 405 ? "Method Not Allowed" : status == 413 ? "Payload Too Large"
+         : status == 429 ? "Too Many Requests" : "Internal Server Error";
+   string out = "HTTP/1.1 " + to_string(status) + " " + reason + "\r\n" + headers + "Content-Length: "
+         + to_string(body.size());
+   if (!body.empty()) {
+      out += "\r\nContent-Type: application/json";
+   }
+   out += keepAlive ? "\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+   return out + body;
+}
+
+} // namespace http
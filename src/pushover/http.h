@@ -0,0 +1,50 @@
+/*
+ * http.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PUSHOVER_HTTP_H_
+#define PUSHOVER_HTTP_H_
+
+#include <stddef.h>
+#include <string>
+
+/** @brief Minimal HTTP/1.1 request parsing for the embedded listeners */
+namespace http {
+
+/** @brief A complete request */
+struct Request {
+   std::string method;
+   std::string target;  ///< path and query
+   std::string body;
+   bool keepAlive = true;
+};
+
+enum Parse {
+   Incomplete, Complete, TooLarge, Invalid  ///< Invalid: malformed Content-Length
+};
+
+/** @brief Take the first complete request from a connection buffer
+ * @param buffer received bytes, the request is removed on success
+ * @param request parsed request
+ * @param maxSize limit of header and body
+ */
+Parse parse(std::string& buffer, Request& request, size_t maxSize);
+
+/** @brief Decode a form url encoded value */
+std::string url_decode(const std::string& value);
+/** @brief Value of a field of a form url encoded body or query, empty if missing */
+std::string form_field(const std::string& form, const char* name);
+
+/** @brief Build a response
+ * @param status HTTP status
+ * @param body JSON body, may be empty
+ * @param headers additional header lines, each terminated by CRLF
+ */
+std::string response(int status, const std::string& body, bool keepAlive, const std::string& headers = std::string());
+
+} // namespace http
+
+#endif /* PUSHOVER_HTTP_H_ */
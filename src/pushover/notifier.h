@@ -0,0 +1,45 @@
+/*
+ * notifier.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PUSHOVER_NOTIFIER_H_
+#define PUSHOVER_NOTIFIER_H_
+
+#include <string>
+#include "pushover.h"
+
+/** @brief A notification of a watchdog, the fields follow the pushover.net parameters */
+struct Notification {
+   std::string source;    ///< name of the plc, empty for the command line plc or a digest
+   std::string title;
+   std::string message;
+   std::string priority;  ///< -2 .. 2, 2 is an emergency requiring an acknowledgement
+   std::string retry;
+   std::string expire;
+   std::string key;
+   std::string token;
+   std::string device;    ///< empty for all devices
+   std::string callback;  ///< acknowledgement URL of an emergency, may be empty
+};
+
+/** @brief A backend delivering notifications
+ *
+ * send() must not wait for the delivery; a backend doing blocking I/O is run on a lane
+ * of its own by the FanOut.
+ */
+class Notifier {
+public:
+   virtual ~Notifier() {
+   }
+   /** @brief Name used in the log and the statistics */
+   virtual const char* name() const = 0;
+   /** @brief Deliver a notification
+    * @param done called exactly once with the outcome, ok and status 1 on success, may be called on any thread
+    */
+   virtual void send(const Notification& notification, PushoverCallback done) = 0;
+};
+
+#endif /* PUSHOVER_NOTIFIER_H_ */
@@ -0,0 +1,459 @@
+/*
+ * outbox.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "outbox.h"
+#include "log.hpp"
+
+using namespace std;
+
+/* pushover.net asks to wait at least 5 seconds before retrying */
+static const chrono::seconds firstDelay(5);
+static const chrono::minutes maxDelay(5);
+/* a notification older than this is of no use anymore */
+static const chrono::hours giveUp(1);
+/* the journal is rewritten once it is larger and mostly closed records */
+static const size_t compactSize = 1 << 20;
+
+/*
+ * Journal records: u32 payload size, u32 crc32 of the payload, payload.
+ * The payload starts with its type, strings are u32 size and bytes, numbers are host order.
+ *   'M' id source title message priority retry expire key token device callback
+ *   'D' id                     message delivered or given up
+ *   'R' receipt source token   receipt of a delivered emergency opened
+ *   'C' receipt                receipt closed
+ */
+namespace {
+
+uint32_t crc32(const char* data, size_t size) {
+   uint32_t crc = 0xffffffff;
+   for (size_t i = 0; i < size; ++i) {
+      crc ^= (uint8_t) data[i];
+      for (int bit = 0; bit < 8; ++bit) {
+         crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+      }
+   }
+   return ~crc;
+}
+
+void put(string& out, uint64_t value) {
+   out.append((const char*) &value, sizeof(value));
+}
+
+void put(string& out, const string& value) {
+   uint32_t size = value.size();
+   out.append((const char*) &size, sizeof(size));
+   out += value;
+}
+
+string frame(const string& payload) {
+   uint32_t header[2] = { (uint32_t) payload.size(), crc32(payload.data(), payload.size()) };
+   return string((const char*) header, sizeof(header)) + payload;
+}
+
+/** @brief Reads the fields of a payload */
+class Fields {
+public:
+   Fields(const char* data, size_t size) :
+         p(data), end(data + size) {
+   }
+   bool get(uint64_t& value) {
+      if (end - p < (ptrdiff_t) sizeof(value)) {
+         return false;
+      }
+      memcpy(&value, p, sizeof(value));
+      p += sizeof(value);
+      return true;
+   }
+   bool get(string& value) {
+      uint32_t size;
+      if (end - p < (ptrdiff_t) sizeof(size)) {
+         return false;
+      }
+      memcpy(&size, p, sizeof(size));
+      p += sizeof(size);
+      if ((size_t) (end - p) < size) {
+         return false;
+      }
+      value.assign(p, size);
+      p += size;
+      return true;
+   }
+private:
+   const char* p;
+   const char* end;
+};
+
+bool write_all(int fd, const string& data) {
+   size_t done = 0;
+   while (done < data.size()) {
+      ssize_t n = write(fd, data.data() + done, data.size() - done);
+      if (n < 0 && errno == EINTR) {
+         continue;
+      }
+      if (n <= 0) {
+         return false;
+      }
+      done += n;
+   }
+   return true;
+}
+
+}
+
+Outbox::Outbox(Pushover& pushover) :
+      pushover(pushover), thread(&Outbox::run, this) {
+}
+
+Outbox::~Outbox() {
+   unique_lock<std::mutex> lock(mutex);
+   running = false;
+   wake.notify_all();
+   // the answers of the requests in flight refer to this outbox
+   wake.wait(lock, [this] {return inFlight == 0;});
+   lock.unlock();
+   thread.join();
+   if (fd >= 0) {
+      close(fd);
+   }
+}
+
+bool Outbox::open(const string& file) {
+   path = file;
+   if (!load() || !compact()) {
+      return false;
+   }
+   lock_guard<std::mutex> lock(mutex);
+   tcout() << "Outbox: " << messages.size() << " pending message(s), " << receipts.size() << " open receipt(s) in "
+         << path << endl;
+   return true;
+}
+
+/** @brief Read the journal of the last run, a torn record at the end is ignored */
+bool Outbox::load() {
+   int in = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+   if (in < 0) {
+      if (errno == ENOENT) {
+         return true;
+      }
+      tcerr() << "Outbox: unable to open " << path << ": " << strerror(errno) << endl;
+      return false;
+   }
+   string data;
+   char chunk[65536];
+   ssize_t n;
+   while ((n = read(in, chunk, sizeof(chunk))) > 0 || (n < 0 && errno == EINTR)) {
+      data.append(chunk, n > 0 ? n : 0);
+   }
+   close(in);
+
+   lock_guard<std::mutex> lock(mutex);
+   size_t pos = 0;
+   while (data.size() - pos >= 8) {
+      uint32_t header[2];
+      memcpy(header, data.data() + pos, sizeof(header));
+      if (data.size() - pos - 8 < header[0] || crc32(data.data() + pos + 8, header[0]) != header[1]
+            || header[0] == 0) {
+         break;
+      }
+      const char* payload = data.data() + pos + 8;
+      Fields fields(payload + 1, header[0] - 1);
+      uint64_t id = 0;
+      string receipt;
+      if (payload[0] == 'M' && fields.get(id)) {
+         Message m;
+         if (fields.get(m.source) && fields.get(m.title) && fields.get(m.message) && fields.get(m.priority)
+               && fields.get(m.retry) && fields.get(m.expire) && fields.get(m.key) && fields.get(m.token)
+               && fields.get(m.device) && fields.get(m.callback)) {
+            m.record = data.substr(pos, 8 + header[0]);
+            m.first = clock::now();
+            m.next = clock::time_point::max();
+            m.restored = true;
+            messages[id] = move(m);
+            nextId = max(nextId, id + 1);
+         }
+      } else if (payload[0] == 'D' && fields.get(id)) {
+         messages.erase(id);
+      } else if (payload[0] == 'R' && fields.get(receipt)) {
+         Receipt& r = receipts[receipt];
+         fields.get(r.source);
+         fields.get(r.token);
+         r.record = data.substr(pos, 8 + header[0]);
+      } else if (payload[0] == 'C' && fields.get(receipt)) {
+         receipts.erase(receipt);
+      }
+      pos += 8 + header[0];
+   }
+   if (pos < data.size()) {
+      tcerr() << "Outbox: ignoring " << data.size() - pos << " bytes of a torn record in " << path << endl;
+   }
+   return true;
+}
+
+/** @brief Replace the journal by the live records, open() or outbox thread only
+ *
+ * The records are written to a new file which is renamed over the journal, a crash leaves
+ * either the old or the new one.
+ */
+bool Outbox::compact() {
+   string records;
+   {
+      lock_guard<std::mutex> lock(mutex);
+      for (const auto& m : messages) {
+         records += m.second.record;
+      }
+      for (const auto& r : receipts) {
+         records += r.second.record;
+      }
+      // the buffered records are part of the live ones
+      buffer.clear();
+   }
+   string tmp = path + ".tmp";
+   int out = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+   if (out < 0 || !write_all(out, records) || fdatasync(out) < 0 || rename(tmp.c_str(), path.c_str()) < 0) {
+      tcerr() << "Outbox: unable to write " << path << ": " << strerror(errno) << endl;
+      if (out >= 0) {
+         close(out);
+         unlink(tmp.c_str());
+      }
+      return false;
+   }
+   // make the rename durable
+   vector<char> dir(path.begin(), path.end());
+   dir.push_back('\0');
+   int dirFd = ::open(dirname(dir.data()), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (dirFd >= 0) {
+      fsync(dirFd);
+      close(dirFd);
+   }
+
+   lock_guard<std::mutex> lock(mutex);
+   if (fd >= 0) {
+      close(fd);
+   }
+   fd = out;
+   written = records.size();
+   return true;
+}
+
+void Outbox::replay(const Adopt& adopt) {
+   vector<pair<string, Receipt>> open;
+   {
+      lock_guard<std::mutex> lock(mutex);
+      open.assign(receipts.begin(), receipts.end());
+      for (auto it = messages.begin(); it != messages.end();) {
+         Message& m = it->second;
+         if (!m.restored) {
+            ++it;
+         } else if (m.priority == "2") {
+            tcout() << "Outbox: dropping emergency '" << m.title << "' of " << m.source << " from the last run" << endl;
+            string payload("D");
+            put(payload, it->first);
+            buffer += frame(payload);
+            it = messages.erase(it);
+         } else {
+            m.restored = false;
+            m.next = clock::now();
+            ++it;
+         }
+      }
+      wake.notify_all();
+   }
+   for (const auto& r : open) {
+      if (adopt(r.second.source, r.first, r.second.token)) {
+         tcout() << "Outbox: following receipt " << r.first << " of " << r.second.source << " again" << endl;
+      } else {
+         closed(r.first);
+      }
+   }
+}
+
+void Outbox::push_emergency(const string& source, const char* title, const char* message, const char* priority,
+      const char* retry, const char* expire, const char* key, const char* token, const char* device,
+      const char* callback, PushoverCallback done) {
+   Message m;
+   m.source = source;
+   m.title = title;
+   m.message = message;
+   m.priority = priority;
+   m.retry = retry;
+   m.expire = expire;
+   m.key = key;
+   m.token = token;
+   m.device = device ? device : "";
+   m.callback = callback ? callback : "";
+   m.done = move(done);
+   m.first = clock::now();
+   m.next = clock::time_point::max();
+
+   // only the serialization is paid here, the outbox thread writes and syncs
+   lock_guard<std::mutex> lock(mutex);
+   uint64_t id = nextId++;
+   string payload("M");
+   put(payload, id);
+   for (const string* field : { &m.source, &m.title, &m.message, &m.priority, &m.retry, &m.expire, &m.key, &m.token,
+         &m.device, &m.callback }) {
+      put(payload, *field);
+   }
+   m.record = frame(payload);
+   if (fd >= 0) {
+      buffer += m.record;
+      wake.notify_all();
+   }
+   send(id, m);
+   messages.emplace(id, move(m));
+}
+
+void Outbox::closed(const string& receipt) {
+   lock_guard<std::mutex> lock(mutex);
+   if (receipts.erase(receipt) && fd >= 0) {
+      string payload("C");
+      put(payload, receipt);
+      buffer += frame(payload);
+      wake.notify_all();
+   }
+}
+
+size_t Outbox::pending() const {
+   lock_guard<std::mutex> lock(mutex);
+   return messages.size();
+}
+
+size_t Outbox::drain(clock::time_point deadline) {
+   unique_lock<std::mutex> lock(mutex);
+   clock::time_point now = clock::now();
+   for (auto& m : messages) {
+      // waiting for the next attempt, the others are in flight or wait for replay()
+      if (!m.second.restored && m.second.next != clock::time_point::max()) {
+         m.second.next = now;
+      }
+   }
+   wake.notify_all();
+   wake.wait_until(lock, deadline, [this] {return messages.empty();});
+   return messages.size();
+}
+
+/** @brief Hand a message to the client, with the lock held */
+void Outbox::send(uint64_t id, const Message& m) {
+   ++inFlight;
+   pushover.push_emergency(m.title.c_str(), m.message.c_str(), m.priority.c_str(), m.retry.c_str(), m.expire.c_str(),
+         m.key.c_str(), m.token.c_str(), m.device.empty() ? NULL : m.device.c_str(),
+         m.callback.empty() ? NULL : m.callback.c_str(), [this, id](const PushoverResult& result) {
+            delivered(id, result);
+         });
+}
+
+/** @brief Answer of a message, on the dispatcher thread */
+void Outbox::delivered(uint64_t id, const PushoverResult& result) {
+   PushoverCallback done;
+   {
+      lock_guard<std::mutex> lock(mutex);
+      --inFlight;
+      wake.notify_all();
+      auto it = messages.find(id);
+      if (it == messages.end()) {
+         return;
+      }
+      Message& m = it->second;
+      bool accepted = result.ok && result.status == 1;
+      bool rejected = result.dropped || (result.http >= 400 && result.http < 500);
+      if (!accepted && !rejected) {
+         if (!running) {
+            // stays in the journal for the next run
+            return;
+         }
+         if (clock::now() - m.first < giveUp) {
+            clock::duration delay = min<clock::duration>(maxDelay, firstDelay * (1 << min(m.attempts++, 6)));
+            m.next = clock::now() + delay;
+            tcout() << "Outbox: '" << m.title << "' failed, retry in "
+                  << chrono::duration_cast<chrono::seconds>(delay).count() << " s" << endl;
+            return;
+         }
+         tcerr() << "Outbox: '" << m.title << "' given up after " << m.attempts + 1 << " attempts" << endl;
+      } else if (rejected && !result.dropped) {
+         tcerr() << "Outbox: '" << m.title << "' rejected by the API, not retried" << endl;
+      }
+      if (fd >= 0) {
+         if (accepted && m.priority == "2" && !result.receipt.empty()) {
+            string payload("R");
+            put(payload, result.receipt);
+            put(payload, m.source);
+            put(payload, m.token);
+            receipts[result.receipt] = Receipt { m.source, m.token, frame(payload) };
+            buffer += receipts[result.receipt].record;
+         }
+         string payload("D");
+         put(payload, id);
+         buffer += frame(payload);
+      }
+      done = move(m.done);
+      messages.erase(it);
+   }
+   if (done) {
+      done(result);
+   }
+}
+
+/** @brief Outbox thread, commits the journal in batches and resends the due messages */
+void Outbox::run() {
+   unique_lock<std::mutex> lock(mutex);
+   for (;;) {
+      if (!buffer.empty()) {
+         // everything appended while the last batch was synced goes with this one
+         string batch;
+         batch.swap(buffer);
+         int out = fd;
+         lock.unlock();
+         if (out >= 0 && (!write_all(out, batch) || fdatasync(out) < 0)) {
+            tcerr() << "Outbox: unable to write " << path << ": " << strerror(errno) << endl;
+         }
+         lock.lock();
+         written += batch.size();
+         if (written > compactSize) {
+            size_t live = 0;
+            for (const auto& m : messages) {
+               live += m.second.record.size();
+            }
+            for (const auto& r : receipts) {
+               live += r.second.record.size();
+            }
+            if (written > 4 * live) {
+               lock.unlock();
+               compact();
+               lock.lock();
+            }
+         }
+         continue;
+      }
+
+      clock::time_point now = clock::now();
+      clock::time_point next = clock::time_point::max();
+      for (auto& m : messages) {
+         if (running && m.second.next <= now) {
+            m.second.next = clock::time_point::max();
+            send(m.first, m.second);
+         } else {
+            next = min(next, m.second.next);
+         }
+      }
+      if (!running && inFlight == 0) {
+         break;
+      }
+      if (next == clock::time_point::max()) {
+         wake.wait(lock);
+      } else {
+         wake.wait_until(lock, next);
+      }
+   }
+}
@@ -0,0 +1,111 @@
+/*
+ * outbox.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PUSHOVER_OUTBOX_H_
+#define PUSHOVER_OUTBOX_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "pushover.h"
+
+/** @brief Delivers the notifications until pushover.net accepted them, across restarts
+ *
+ * Every message is kept until it is delivered or rejected for good (HTTP 4xx), transient
+ * failures are retried with an increasing delay. With a journal the pending messages and the
+ * open receipts of the emergencies survive a restart of the daemon.
+ *
+ * The journal is an append-only file of checksummed records. Callers only serialize their record
+ * into a buffer; the outbox thread writes the buffer and syncs it with a single fdatasync() per
+ * batch (group commit), so a burst of events costs one sync. The file is rewritten with the live
+ * records on startup and once it outgrew them.
+ */
+class Outbox {
+public:
+   typedef std::chrono::steady_clock clock;
+   /** @brief Takes over an open receipt of the last run
+    * @return false if nobody follows it anymore, e.g. the plc was removed from the configuration
+    */
+   typedef std::function<bool(const std::string& source, const std::string& receipt, const std::string& token)> Adopt;
+
+   explicit Outbox(Pushover& pushover);
+   /** @brief Commit the journal and wait for the requests in flight, pending messages stay in the journal */
+   ~Outbox();
+   Outbox(const Outbox&) = delete;
+   Outbox& operator=(const Outbox&) = delete;
+
+   /** @brief Load and compact the journal, nothing is sent before replay()
+    * @param path journal file, created if missing
+    * @return false if the journal can not be written, errors are logged
+    */
+   bool open(const std::string& path);
+   /** @brief Resend the pending messages of the last run and hand out its open receipts
+    *
+    * Emergencies not delivered in the last run are dropped, the watchdogs push them again
+    * if the plc is still in STOP.
+    */
+   void replay(const Adopt& adopt);
+
+   /** @brief Send a notification, the parameters are the ones of Pushover::push_emergency()
+    * @param source name of the plc, the open receipt of an emergency is handed back to it by replay()
+    * @param done called once the message is delivered or given up, not on transient failures
+    */
+   void push_emergency(const std::string& source, const char* title, const char* message, const char* priority,
+         const char* retry, const char* expire, const char* key, const char* token, const char* device,
+         const char* callback = NULL, PushoverCallback done = nullptr);
+   /** @brief Forget a receipt once its emergency is closed */
+   void closed(const std::string& receipt);
+
+   /** @brief Messages not delivered yet */
+   size_t pending() const;
+   /** @brief Retry the pending messages at once and wait until they are delivered or deadline passed
+    * @return messages still pending, they stay in the journal
+    */
+   size_t drain(clock::time_point deadline);
+
+private:
+   struct Message {
+      std::string source, title, message, priority, retry, expire, key, token, device, callback;
+      std::string record;      ///< journal record, written again by the compaction
+      PushoverCallback done;
+      clock::time_point first; ///< first attempt
+      clock::time_point next;  ///< next attempt, max while sending or not replayed yet
+      int attempts = 0;
+      bool restored = false;   ///< loaded from the journal, waits for replay()
+   };
+
+   struct Receipt {
+      std::string source, token;
+      std::string record;
+   };
+
+   void send(uint64_t id, const Message& message);
+   void delivered(uint64_t id, const PushoverResult& result);
+   void run();
+   bool load();
+   bool compact();
+
+   Pushover& pushover;
+   mutable std::mutex mutex;
+   std::condition_variable wake;
+   std::map<uint64_t, Message> messages;          ///< pending messages by id
+   std::map<std::string, Receipt> receipts;      ///< open receipts of the emergencies
+   uint64_t nextId = 1;
+   std::string path;
+   int fd = -1;
+   std::string buffer;        ///< records not written yet
+   size_t written = 0;        ///< size of the journal file
+   int inFlight = 0;          ///< requests not answered yet
+   bool running = true;
+   std::thread thread;
+};
+
+#endif /* PUSHOVER_OUTBOX_H_ */
@@ -5,20 +5,62 @@
  *      Author: CBe
  */
 
+#include <algorithm>
 #include <string>
 #include <iostream>
+#include <stdlib.h>
+#include <string.h>
 #include <curl/curl.h>
 #include "pushover.h"
 
-#include "rapidjson/document.h"
-#include "rapidjson/writer.h"
-#include "rapidjson/stringbuffer.h"
-
+#include "response.h"
 #include "log.hpp"
 
 using namespace std;
 
-/** @brief Parse json response, got from libcurl
+/* complete connection within 10 seconds */
+static const long connectTimeout = 10;
+/* a hanging transfer is aborted after 30 seconds */
+static const long transferTimeout = 30;
+/* pushover.net asks for no more than two concurrent requests */
+static const int maxTransfers = 2;
+/* informational messages are of no use once they are that late */
+static const chrono::minutes staleAfter(5);
+/* over quota without X-Limit-App-Reset, the other messages are admitted again after an hour */
+static const time_t quotaRetry = 3600;
+
+namespace {
+
+/** @brief X-Limit-App-* headers of an answer */
+struct Quota {
+   long limit = -1;
+   long remaining = -1;
+   time_t reset = 0;
+};
+
+}
+
+/** @brief A queued or running request, owned by the dispatcher once queued */
+struct Pushover::Request {
+   PushoverResult::Request kind;
+   const char* function;  ///< name used in the log
+   string url;
+   string post;           ///< POST data, GET if empty
+   PushoverCallback done;
+   Handle* handle = nullptr;  ///< while running
+   int priority = 2;          ///< pushover.net priority, receipts are part of an emergency
+   chrono::steady_clock::time_point queued = chrono::steady_clock::now();
+   unsigned long sequence = 0;
+};
+
+/** @brief An easy handle and its response buffer, both reused by the following requests */
+struct Pushover::Handle {
+   CURL* curl;
+   string response;       ///< keeps its capacity, the parsing allocates nothing
+   Quota quota;
+};
+
+/** @brief Collect the json response, got from libcurl
  */
 static size_t curl_process(void *contents, size_t size, size_t nmemb,
       std::string *curl_response) {
@@ -31,223 +73,343 @@ static size_t curl_process(void *contents, size_t size, size_t nmemb,
    return realsize;
 }
 
-string push_emergency(const char* title, const char* message, const char* priority, const char* retry,
-      const char* expire, const char* key, const char* token, const char* device) {
-   string receipt;
-   CURL *curl;
-   CURLcode res;
-
-   /* In windows, this will init the winsock stuff */
-   curl_global_init(CURL_GLOBAL_ALL);
-
-   /* get a curl handle */
-   curl = curl_easy_init();
-   if (curl) {
-      string post_data = "token=";
-      post_data += token;
-      post_data += "&user=";
-      post_data += key;
-      post_data += "&priority=";
-      post_data += priority;
-      post_data += "&retry=";
-      post_data += retry;
-      post_data += "&expire=";
-      post_data += expire;
-      if (device) {
-         post_data += "&device=";
-         post_data += device;
-      }
-      post_data += "&title=";
-      post_data += title;
-      post_data += "&message=";
-      post_data += message;
+/** @brief Pick the quota headers, libcurl passes each header line separately
+ */
+static size_t curl_header(char* buffer, size_t size, size_t nitems, Quota* quota) {
+   size_t realsize = size * nitems;
+   string line(buffer, realsize);
+   if (!strncasecmp(line.c_str(), "X-Limit-App-Limit:", 18)) {
+      quota->limit = strtol(line.c_str() + 18, NULL, 10);
+   } else if (!strncasecmp(line.c_str(), "X-Limit-App-Remaining:", 22)) {
+      quota->remaining = strtol(line.c_str() + 22, NULL, 10);
+   } else if (!strncasecmp(line.c_str(), "X-Limit-App-Reset:", 18)) {
+      quota->reset = (time_t) strtoll(line.c_str() + 18, NULL, 10);
+   }
+   return realsize;
+}
 
-      tcout() << "Request: " << post_data << endl;
+/** @brief Part of the quota kept for the messages of a higher priority */
+static long reserve(int priority, long limit) {
+   if (priority >= 2) {
+      return 0;
+   } else if (priority == 1) {
+      return limit / 100;
+   } else if (priority == 0) {
+      return limit / 20;
+   }
+   return limit / 10;
+}
 
-      // The pushover response is parsed into a rapidjson::Document
-      std::string response;
+const char* const Pushover::defaultApi = "https://api.pushover.net/1";
+
+Pushover::Pushover(const string& api) :
+      api(api) {
+   // the handles are only used by the dispatcher thread, no need for share locks
+   share = curl_share_init();
+   curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+   curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+   // the multi handle keeps the connections to the API alive
+   multi = curl_multi_init();
+   curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, 8L);
+   dispatcher = thread(&Pushover::run, this);
+}
 
-      /* First set the URL that is about to receive our POST. This URL can
-       just as well be a https:// URL if that is what should receive the
-       data. */
-      curl_easy_setopt(curl, CURLOPT_URL,
-            "https://api.pushover.net/1/messages.json");
-      /* Now specify the POST data */
-      curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data.c_str());
-      /* Set a function that will be called to store the output */
-      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &curl_process);
-      /* set the curl_process parameter */
-      curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-      /* complete connection within 10 seconds */
-      curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
-
-      /* Perform the request, res will get the return code */
-      rapidjson::Document document;
-      res = curl_easy_perform(curl);
-      document.Parse(response.c_str());
-      /* Check for errors */
-      if (res != CURLE_OK) {
-         tcerr() << "curl_easy_perform() failed: " << curl_easy_strerror(res) << endl;
-      } else if(document.HasParseError()) {
-         tcerr() << "document has parse error" << endl;
-      } else {
-         // evaluate json document, extract receipt
-         if (!document.HasMember("status") || document["status"].GetInt() != 1) {
-            if (document.HasMember("errors")) {
-               const rapidjson::Value& errors = document["errors"];
-               for(rapidjson::Value::ConstValueIterator itr = errors.Begin(); itr != errors.End(); ++itr) {
-                  tcout() << "push_emergency(): " << itr->GetString() << endl;
-               }
-            } else {
-               tcout() << "push_emergency(): Unable to access pushover.net" << endl;
-            }
-         }
-         if (document.HasMember("receipt")) {
-            receipt = document["receipt"].GetString();
-            tcout() << "Receipt: " << receipt << endl;
+Pushover::~Pushover() {
+   running = false;
+   curl_multi_wakeup(multi);
+   dispatcher.join();
+   for (Handle* handle : idle) {
+      curl_easy_cleanup(handle->curl);
+      delete handle;
+   }
+   curl_multi_cleanup(multi);
+   curl_share_cleanup(share);
+}
+
+void Pushover::enqueue(unique_ptr<Request> request) {
+   queue.push(move(request));
+   curl_multi_wakeup(multi);
+}
+
+/** @brief Dispatcher thread, runs the transfers until destruction and the queue is drained */
+void Pushover::run() {
+   // higher priority first, then first come
+   auto later = [](const unique_ptr<Request>& a, const unique_ptr<Request>& b) {
+      return a->priority < b->priority || (a->priority == b->priority && a->sequence > b->sequence);
+   };
+   int transfers = 0;
+   for (;;) {
+      unique_ptr<Request> request;
+      while (queue.pop(request)) {
+         request->sequence = ++sequence;
+         waiting.push_back(move(request));
+         push_heap(waiting.begin(), waiting.end(), later);
+      }
+      while (active < maxTransfers && !waiting.empty()) {
+         pop_heap(waiting.begin(), waiting.end(), later);
+         request = move(waiting.back());
+         waiting.pop_back();
+         if (request->kind == PushoverResult::Push && request->priority <= 0
+               && chrono::steady_clock::now() - request->queued > staleAfter) {
+            reject(move(request), "stale");
+         } else if (!admit(*request)) {
+            reject(move(request), "quota reserved for higher priorities");
+         } else {
+            start(move(request));
          }
       }
+      held = waiting.size();
+      curl_multi_perform(multi, &transfers);
 
-      /* always cleanup */
-      curl_easy_cleanup(curl);
+      int pending;
+      while (CURLMsg* msg = curl_multi_info_read(multi, &pending)) {
+         if (msg->msg == CURLMSG_DONE) {
+            finish(msg->easy_handle, msg->data.result);
+         }
+      }
+      if (!running && transfers == 0 && waiting.empty() && queue.empty()) {
+         break;
+      }
+      // a finished transfer made room for a waiting request
+      curl_multi_poll(multi, NULL, 0, active < maxTransfers && !waiting.empty() ? 0 : 1000, NULL);
    }
-   curl_global_cleanup();
-
-   return receipt;
 }
 
-void cancel_emergency(const string& receipt, const char* token) {
-   CURL *curl;
-   CURLcode res;
+/** @brief Take an idle easy handle or create one, options are reset to the common ones */
+Pushover::Handle* Pushover::acquire() {
+   Handle* handle = NULL;
+   if (!idle.empty()) {
+      handle = idle.back();
+      idle.pop_back();
+      // keeps the DNS and TLS session caches
+      curl_easy_reset(handle->curl);
+   } else {
+      CURL* curl = curl_easy_init();
+      if (!curl) {
+         return NULL;
+      }
+      handle = new Handle { curl, string(), Quota() };
+   }
+   handle->response.clear();
+   CURL* curl = handle->curl;
+   curl_easy_setopt(curl, CURLOPT_SHARE, share);
+   /* Set a function that will be called to store the output */
+   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &curl_process);
+   curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, connectTimeout);
+   curl_easy_setopt(curl, CURLOPT_TIMEOUT, transferTimeout);
+   /* keep the connection to the API open between the receipt polls */
+   curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+   curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+   curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 15L);
+   /* multi threaded, no signals for DNS timeouts */
+   curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+   /* set the curl_process parameter */
+   curl_easy_setopt(curl, CURLOPT_WRITEDATA, &handle->response);
+   handle->quota = Quota();
+   curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &curl_header);
+   curl_easy_setopt(curl, CURLOPT_HEADERDATA, &handle->quota);
+   return handle;
+}
 
-   /* In windows, this will init the winsock stuff */
-   curl_global_init(CURL_GLOBAL_ALL);
+void Pushover::start(unique_ptr<Request> request) {
+   Handle* handle = acquire();
+   if (!handle) {
+      tcerr() << request->function << ": curl_easy_init() failed" << endl;
+      if (request->done) {
+         PushoverResult result;
+         result.request = request->kind;
+         request->done(result);
+      }
+      return;
+   }
+   CURL* curl = handle->curl;
+   request->handle = handle;
+   curl_easy_setopt(curl, CURLOPT_URL, request->url.c_str());
+   if (!request->post.empty()) {
+      /* Now specify the POST data */
+      curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request->post.c_str());
+   }
+   curl_easy_setopt(curl, CURLOPT_PRIVATE, request.get());
+   curl_multi_add_handle(multi, curl);
+   ++active;
+   if (request->kind == PushoverResult::Push && remaining > 0) {
+      // estimate until the answer tells
+      --remaining;
+   }
+   (void) request.release();
+}
 
-   /* get a curl handle */
-   curl = curl_easy_init();
-   if (curl) {
-      string get_data = "https://api.pushover.net/1/receipts/" + receipt
-            + "/cancel.json";
-      string post_data = "token=";
-      post_data += token;
+/** @brief Check whether a request may use the quota, dispatcher thread only
+ *
+ * Receipt polls and cancels do not count, emergencies may use up the quota. The other
+ * messages leave a reserve for the higher priorities.
+ */
+bool Pushover::admit(const Request& request) {
+   if (request.kind != PushoverResult::Push || request.priority >= 2) {
+      return true;
+   }
+   if (reset && time(NULL) >= reset) {
+      // a new period, the next answer tells the quota
+      remaining = -1;
+   }
+   return remaining < 0 || remaining > reserve(request.priority, limit);
+}
 
-      tcout() << "Request: " << get_data << "?" << post_data << endl;
+void Pushover::reject(unique_ptr<Request> request, const char* reason) {
+   ++dropped;
+   tcerr() << request->function << ": dropped message of priority " << request->priority << ", " << reason << endl;
+   if (request->done) {
+      PushoverResult result;
+      result.request = request->kind;
+      result.dropped = true;
+      request->done(result);
+   }
+}
 
-      // The pushover response is parsed into a rapidjson::Document
-      std::string response;
+Pushover::Budget Pushover::budget() const {
+   Budget budget;
+   budget.limit = limit;
+   budget.remaining = remaining;
+   budget.reset = reset;
+   budget.waiting = held;
+   budget.dropped = dropped;
+   return budget;
+}
 
-      /* First set the URL that is about to receive our POST. This URL can
-       just as well be a https:// URL if that is what should receive the
-       data. */
-      curl_easy_setopt(curl, CURLOPT_URL, get_data.c_str());
-      /* Now specify the POST data */
-      curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data.c_str());
-      /* Set a function that will be called to store the output */
-      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &curl_process);
-      /* set the curl_process parameter */
-      curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-      /* complete connection within 10 seconds */
-      curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
-
-      /* Perform the request, res will get the return code */
-      rapidjson::Document document;
-      res = curl_easy_perform(curl);
-      document.Parse(response.c_str());
-      /* Check for errors */
-      if (res != CURLE_OK) {
-         tcerr() << "curl_easy_perform() failed: " << curl_easy_strerror(res)
-               << endl;
-      } else if(document.HasParseError()) {
-         tcerr() << "document has parse error" << endl;
-      }else {
-         // evaluate json document, extract receipt
-         if (!document.HasMember("status") || document["status"].GetInt() != 1) {
-            if (document.HasMember("errors")) {
-               const rapidjson::Value& errors = document["errors"];
-               for(rapidjson::Value::ConstValueIterator itr = errors.Begin(); itr != errors.End(); ++itr) {
-                  tcout() << "cancel_emergency(): " << itr->GetString() << endl;
-               }
-            } else {
-               tcout() << "cancel_emergency(): Unable to access pushover.net" << endl;
-            }
-         }
+/** @brief Parse the response of a completed transfer and report it
+ */
+void Pushover::finish(CURL* curl, CURLcode res) {
+   Request* raw = NULL;
+   curl_easy_getinfo(curl, CURLINFO_PRIVATE, &raw);
+   unique_ptr<Request> request(raw);
+   curl_multi_remove_handle(multi, curl);
+   --active;
+
+   const Quota& quota = request->handle->quota;
+   if (quota.remaining >= 0) {
+      long low = reserve(1, quota.limit);
+      if ((remaining < 0 || remaining > low) && quota.remaining <= low) {
+         tcerr() << "Message quota low: " << quota.remaining << " of " << quota.limit << " left" << endl;
       }
+      limit = quota.limit;
+      remaining = quota.remaining;
+      reset = quota.reset;
+   }
+   long code = 0;
+   curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+   if (code == 429) {
+      // over quota, only emergencies are tried until the reset
+      remaining = 0;
+      if (reset <= time(NULL)) {
+         // no usable reset time, try the others again after a while
+         reset = time(NULL) + quotaRetry;
+      }
+   }
 
-      /* always cleanup */
-      curl_easy_cleanup(curl);
-   }
-   curl_global_cleanup();
-}
-
-bool poll_receipt(const string& receipt, const char* token) {
-   bool acknowledged = false;
-
-   CURL *curl;
-   CURLcode res;
-
-   /* In windows, this will init the winsock stuff */
-   curl_global_init(CURL_GLOBAL_ALL);
-
-   /* get a curl handle */
-   curl = curl_easy_init();
-   if (curl) {
-      string get_data = "https://api.pushover.net/1/receipts/" + receipt
-            + ".json?token=";
-      get_data += token;
-
-      tcout() << "Request: " << get_data << endl;
-
-      // The pushover response is parsed into a rapidjson::Document
-      std::string response;
-
-      /* First set the URL that is about to receive our POST. This URL can
-       just as well be a https:// URL if that is what should receive the
-       data. */
-      curl_easy_setopt(curl, CURLOPT_URL, get_data.c_str());
-      /* Set a function that will be called to store the output */
-      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &curl_process);
-      /* set the curl_process parameter */
-      curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-      /* complete connection within 10 seconds */
-      curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
-
-      /* Perform the request, res will get the return code */
-      rapidjson::Document document;
-      res = curl_easy_perform(curl);
-      document.Parse(response.c_str());
-      /* Check for errors */
-      if (res != CURLE_OK) {
-         tcerr() << "curl_easy_perform() failed: " << curl_easy_strerror(res)
-               << endl;
-      } else if(document.HasParseError()) {
-         tcerr() << "document has parse error" << endl;
-      }else {
-         // evaluate json document, extract receipt
-         if (!document.HasMember("status") || document["status"].GetInt() != 1) {
-            if (document.HasMember("errors")) {
-               const rapidjson::Value& errors = document["errors"];
-               for(rapidjson::Value::ConstValueIterator itr = errors.Begin(); itr != errors.End(); ++itr) {
-                  tcout() << "poll_receipt(): " << itr->GetString() << endl;
-               }
-            } else {
-               tcout() << "poll_receipt(): Unable to access pushover.net" << endl;
-            }
-         }
-         if (document.HasMember("acknowledged")
-               && (document["acknowledged"].GetInt() == 1)) {
-            tcout() << "poll_receipt(): emergency acknowledged" << endl;
-            acknowledged = true;
-         }
-         if (document.HasMember("expired")
-               && (document["expired"].GetInt() == 1)) {
-            tcout() << "poll_receipt(): emergency expired" << endl;
+   PushoverResult result;
+   result.request = request->kind;
+   result.http = (int) code;
+   const char* function = request->function;
+
+   // The pushover response is parsed in place, only the fields needed are picked
+   PushoverResponse response;
+   bool parsed = res == CURLE_OK && parse_response(&request->handle->response[0], response);
+   /* Check for errors */
+   if (res != CURLE_OK) {
+      tcerr() << function << ": curl failed: " << curl_easy_strerror(res) << endl;
+   } else if (!parsed) {
+      tcerr() << "document has parse error" << endl;
+   } else {
+      double total = 0;
+      long connects = 0;
+      curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &total);
+      curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+      tcout() << function << ": " << (long) (total * 1000) << " ms" << (connects ? ", new connection" : "") << endl;
+
+      // evaluate response
+      if (response.status != 1) {
+         if (response.errors) {
+            tcout() << function << ": " << response.error
+                  << (response.errors > 1 ? " (" + to_string(response.errors - 1) + " more)" : string()) << endl;
+         } else {
+            tcout() << function << ": Unable to access pushover.net" << endl;
          }
       }
+      if (response.receipt[0]) {
+         // extract receipt
+         result.receipt = response.receipt;
+         tcout() << "Receipt: " << result.receipt << endl;
+      }
+      if (response.acknowledged == 1) {
+         tcout() << "poll_receipt(): emergency acknowledged" << endl;
+         result.acknowledged = true;
+      }
+      if (response.expired == 1) {
+         tcout() << "poll_receipt(): emergency expired" << endl;
+         result.expired = true;
+      }
+      result.ok = true;
+      result.status = response.status;
+   }
+   idle.push_back(request->handle);
+
+   if (request->done) {
+      request->done(result);
+   }
+}
 
-      /* always cleanup */
-      curl_easy_cleanup(curl);
+void Pushover::push_emergency(const char* title, const char* message, const char* priority, const char* retry,
+      const char* expire, const char* key, const char* token, const char* device, const char* callback,
+      PushoverCallback done) {
+   unique_ptr<Request> request(new Request { PushoverResult::Push, "push_emergency()",
+         api + "/messages.json", "", move(done) });
+   request->priority = atoi(priority);
+
+   string& post_data = request->post;
+   post_data = "token=";
+   post_data += token;
+   post_data += "&user=";
+   post_data += key;
+   post_data += "&priority=";
+   post_data += priority;
+   post_data += "&retry=";
+   post_data += retry;
+   post_data += "&expire=";
+   post_data += expire;
+   if (device) {
+      post_data += "&device=";
+      post_data += device;
    }
-   curl_global_cleanup();
+   if (callback) {
+      char* escaped = curl_easy_escape(NULL, callback, 0);
+      if (escaped) {
+         post_data += "&callback=";
+         post_data += escaped;
+         curl_free(escaped);
+      }
+   }
+   post_data += "&title=";
+   post_data += title;
+   post_data += "&message=";
+   post_data += message;
+
+   // token and user key stay out of the log
+   tcout() << "Request: " << request->url << " priority " << priority << ", " << title << endl;
+   enqueue(move(request));
+}
+
+void Pushover::cancel_emergency(const string& receipt, const char* token, PushoverCallback done) {
+   unique_ptr<Request> request(new Request { PushoverResult::Cancel, "cancel_emergency()",
+         api + "/receipts/" + receipt + "/cancel.json", string("token=") + token, move(done) });
+
+   tcout() << "Request: " << request->url << endl;
+   enqueue(move(request));
+}
+
+void Pushover::poll_receipt(const string& receipt, const char* token, PushoverCallback done) {
+   unique_ptr<Request> request(new Request { PushoverResult::Poll, "poll_receipt()",
+         api + "/receipts/" + receipt + ".json?token=" + token, "", move(done) });
 
-   return acknowledged;
+   tcout() << "Request: " << api << "/receipts/" << receipt << ".json" << endl;
+   enqueue(move(request));
 }
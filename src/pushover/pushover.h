@@ -8,30 +8,125 @@
 #ifndef PUSHOVER_PUSHOVER_H_
 #define PUSHOVER_PUSHOVER_H_
 
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+#include "mpscqueue.h"
 
-/** @brief Send an pushover emergency
- * @param title your message's title
- * @param message your message
- * @param priority send as -2 to generate no notification/alert, -1 to always send as a quiet notification, 
- *        1 to display as high-priority and bypass the user's quiet hours, or 2 to also require confirmation from the user
- * @param retry the pushover.net retry parameter
- * @param expire the pushover.net expire parameter
- * @param key the pushover.net user key
- * @param token the pushover.net application token
- * @param device the pushover.net device list e.g "dev1,dev2" or NULL for all devices
- */
-std::string push_emergency(const char* title, const char* message, const char* priority, const char* retry, 
-      const char* expire, const char* key, const char* token, const char* device);
-/** @brief Cancel an emergency
- * @param receipt emergency receipt to poll for
- */
-void cancel_emergency(const std::string& receipt, const char* token);
-/** @brief Poll for acknowledgement
- * @param receipt emergency receipt to poll for
- * @param token the pushover.net application token
- * @return true if notification was acknowledged otherwise false
+/** @brief Outcome of a pushover.net request */
+struct PushoverResult {
+   enum Request {
+      Push, Cancel, Poll
+   };
+   Request request = Push;
+   bool ok = false;            ///< transfer completed and the response parsed
+   int status = 0;             ///< status of the response, 1 if the API accepted the request
+   int http = 0;               ///< HTTP status, 4xx are not worth a retry, 0 without answer
+   bool dropped = false;       ///< not sent to save the quota or being stale
+   std::string receipt;        ///< receipt of an emergency push
+   bool acknowledged = false;  ///< receipt poll: emergency acknowledged
+   bool expired = false;       ///< receipt poll: emergency expired
+};
+
+/** @brief Called on the dispatcher thread once a request completed or failed */
+typedef std::function<void(const PushoverResult&)> PushoverCallback;
+
+/** @brief Non-blocking pushover.net client
+ *
+ * The requests are queued lock-free and return immediately. A dispatcher thread drives
+ * them on the curl multi interface; every transfer is bounded by an overall timeout.
+ * Easy handles are reused and share the DNS cache and TLS sessions, the connections to
+ * the API are kept alive, so a request usually costs a single round trip.
+ *
+ * Only a few transfers run at once, the waiting requests are started by their pushover.net
+ * priority. The monthly message quota is taken from the X-Limit-App-* headers of the answers;
+ * once it runs low the informational messages are dropped first, emergencies may use it up.
+ *
+ * Expects curl_global_init() to be called once by the application before construction.
  */
-bool poll_receipt(const std::string& receipt, const char* token);
+class Pushover {
+public:
+   static const char* const defaultApi;
+
+   /** @brief Message quota of the application and the requests held back */
+   struct Budget {
+      long limit = -1;       ///< messages per month, -1 until the API told
+      long remaining = -1;   ///< messages left, -1 until the API told
+      time_t reset = 0;      ///< end of the quota period
+      size_t waiting = 0;    ///< requests waiting for a transfer
+      unsigned long dropped = 0; ///< messages dropped to save the quota or being stale
+   };
+
+   /** @param api base URL of the API, e.g. a local mock server for tests */
+   explicit Pushover(const std::string& api = defaultApi);
+   /** @brief Finish the queued and running transfers and stop the dispatcher */
+   ~Pushover();
+   Pushover(const Pushover&) = delete;
+   Pushover& operator=(const Pushover&) = delete;
+
+   /** @brief Send an pushover emergency
+    * @param title your message's title
+    * @param message your message
+    * @param priority send as -2 to generate no notification/alert, -1 to always send as a quiet notification,
+    *        1 to display as high-priority and bypass the user's quiet hours, or 2 to also require confirmation from the user
+    * @param retry the pushover.net retry parameter
+    * @param expire the pushover.net expire parameter
+    * @param key the pushover.net user key
+    * @param token the pushover.net application token
+    * @param device the pushover.net device list e.g "dev1,dev2" or NULL for all devices
+    * @param callback URL pushover.net POSTs the acknowledgement of an emergency to, or NULL
+    * @param done receives the receipt, may be empty
+    */
+   void push_emergency(const char* title, const char* message, const char* priority, const char* retry,
+         const char* expire, const char* key, const char* token, const char* device, const char* callback = NULL,
+         PushoverCallback done = nullptr);
+   /** @brief Cancel an emergency
+    * @param receipt emergency receipt to poll for
+    */
+   void cancel_emergency(const std::string& receipt, const char* token, PushoverCallback done = nullptr);
+   /** @brief Poll for acknowledgement
+    * @param receipt emergency receipt to poll for
+    * @param token the pushover.net application token
+    * @param done receives whether the notification was acknowledged
+    */
+   void poll_receipt(const std::string& receipt, const char* token, PushoverCallback done = nullptr);
+
+   /** @brief Current quota, may be called from any thread */
+   Budget budget() const;
+
+private:
+   struct Request;
+   struct Handle;
+
+   void enqueue(std::unique_ptr<Request> request);
+   void run();
+   void start(std::unique_ptr<Request> request);
+   void finish(CURL* curl, CURLcode res);
+   bool admit(const Request& request);
+   void reject(std::unique_ptr<Request> request, const char* reason);
+   Handle* acquire();
+
+   const std::string api;
+   CURLSH* share;
+   CURLM* multi;
+   std::vector<Handle*> idle;  ///< easy handles not in use, dispatcher thread only
+   MpscQueue<std::unique_ptr<Request>> queue;
+   std::vector<std::unique_ptr<Request>> waiting;  ///< heap by priority, dispatcher thread only
+   int active = 0;             ///< transfers running, dispatcher thread only
+   unsigned long sequence = 0; ///< keeps the order of requests of the same priority
+   std::atomic<long> limit { -1 };
+   std::atomic<long> remaining { -1 };
+   std::atomic<time_t> reset { 0 };
+   std::atomic<size_t> held { 0 };
+   std::atomic<unsigned long> dropped { 0 };
+   std::atomic<bool> running { true };
+   std::thread dispatcher;
+};
 
 #endif /* PUSHOVER_PUSHOVER_H_ */
@@ -0,0 +1,192 @@
+/*
+ * receipts.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <iostream>
+#include "receipts.h"
+#include "log.hpp"
+
+using namespace std;
+
+typedef vector<pair<PushoverCallback, PushoverResult>> Events;
+
+static void deliver(Events& events) {
+   for (auto& e : events) {
+      e.first(e.second);
+   }
+}
+
+ReceiptTracker::ReceiptTracker(Pushover& pushover, clock::duration tick) :
+      pushover(pushover), tick(tick), start(clock::now()), thread(&ReceiptTracker::run, this) {
+}
+
+ReceiptTracker::~ReceiptTracker() {
+   unique_lock<std::mutex> lock(mutex);
+   running = false;
+   wake.notify_all();
+   // the answers of the polls in flight refer to this tracker
+   wake.wait(lock, [this] {return inFlight == 0;});
+   lock.unlock();
+   thread.join();
+}
+
+uint64_t ReceiptTracker::ticks(clock::duration d) const {
+   return max<uint64_t>(1, (d + tick - clock::duration(1)) / tick);
+}
+
+void ReceiptTracker::track(const string& receipt, const string& token, clock::duration cadence, clock::duration expire,
+      PushoverCallback done) {
+   lock_guard<std::mutex> lock(mutex);
+   if (entries.empty()) {
+      // the wheel stands still while nothing is open
+      wheel.rebase((clock::now() - start) / tick);
+   }
+   unique_ptr<Entry>& entry = entries[receipt];
+   if (entry) {
+      wheel.cancel(*entry);
+   } else {
+      entry.reset(new Entry);
+   }
+   entry->receipt = receipt;
+   entry->token = token;
+   entry->cadence = ticks(cadence);
+   // leave the API one more poll to report the expiry itself
+   entry->deadline = wheel.now() + ticks(expire) + entry->cadence;
+   entry->done = move(done);
+   wheel.schedule(*entry, wheel.now() + entry->cadence);
+   wake.notify_all();
+}
+
+bool ReceiptTracker::acknowledge(const string& receipt) {
+   Events events;
+   {
+      lock_guard<std::mutex> lock(mutex);
+      auto it = entries.find(receipt);
+      if (it == entries.end()) {
+         return false;
+      }
+      wheel.cancel(*it->second);
+      PushoverResult result;
+      result.request = PushoverResult::Poll;
+      result.ok = true;
+      result.receipt = receipt;
+      result.acknowledged = true;
+      events.emplace_back(move(it->second->done), result);
+      entries.erase(it);
+   }
+   deliver(events);
+   return true;
+}
+
+void ReceiptTracker::cancel(const string& receipt) {
+   Events events;
+   {
+      lock_guard<std::mutex> lock(mutex);
+      auto it = entries.find(receipt);
+      if (it == entries.end()) {
+         return;
+      }
+      wheel.cancel(*it->second);
+      PushoverResult result;
+      result.request = PushoverResult::Cancel;
+      result.receipt = receipt;
+      events.emplace_back(move(it->second->done), result);
+      pushover.cancel_emergency(receipt, it->second->token.c_str());
+      entries.erase(it);
+   }
+   deliver(events);
+}
+
+void ReceiptTracker::release(const string& receipt) {
+   lock_guard<std::mutex> lock(mutex);
+   auto it = entries.find(receipt);
+   if (it != entries.end()) {
+      // the answer of a poll in flight finds no entry and is dropped
+      wheel.cancel(*it->second);
+      entries.erase(it);
+   }
+}
+
+size_t ReceiptTracker::size() const {
+   lock_guard<std::mutex> lock(mutex);
+   return entries.size();
+}
+
+/** @brief Tracker thread, runs the wheel while receipts are open */
+void ReceiptTracker::run() {
+   unique_lock<std::mutex> lock(mutex);
+   while (running) {
+      if (entries.empty()) {
+         wake.wait(lock);
+      } else {
+         wake.wait_until(lock, start + tick * (wheel.now() + 1));
+      }
+      if (!running) {
+         break;
+      }
+      uint64_t now = (clock::now() - start) / tick;
+      if (entries.empty()) {
+         // nothing to fire, catch up without running the ticks
+         wheel.rebase(now);
+         continue;
+      }
+      Events events;
+      wheel.advance(now, [this, &events](TimerWheel::Timer& timer) {
+         fire(static_cast<Entry&>(timer), events);
+      });
+      lock.unlock();
+      deliver(events);
+      lock.lock();
+   }
+}
+
+/** @brief Poll or expire a receipt whose timer is due */
+void ReceiptTracker::fire(Entry& entry, Events& events) {
+   if (wheel.now() >= entry.deadline) {
+      tcout() << entry.receipt << ": emergency expired" << endl;
+      PushoverResult result;
+      result.request = PushoverResult::Poll;
+      result.receipt = entry.receipt;
+      result.expired = true;
+      events.emplace_back(move(entry.done), result);
+      entries.erase(entry.receipt);
+      return;
+   }
+   if (!entry.polling) {
+      entry.polling = true;
+      ++inFlight;
+      string receipt = entry.receipt;
+      pushover.poll_receipt(receipt, entry.token.c_str(), [this, receipt](const PushoverResult& result) {
+         polled(receipt, result);
+      });
+   }
+   wheel.schedule(entry, wheel.now() + entry.cadence);
+}
+
+/** @brief Answer of a poll, on the dispatcher thread */
+void ReceiptTracker::polled(const string& receipt, const PushoverResult& result) {
+   Events events;
+   {
+      lock_guard<std::mutex> lock(mutex);
+      --inFlight;
+      wake.notify_all();
+      auto it = entries.find(receipt);
+      if (it == entries.end()) {
+         return;
+      }
+      Entry& entry = *it->second;
+      entry.polling = false;
+      if (!result.acknowledged && !result.expired) {
+         return;
+      }
+      PushoverResult event = result;
+      event.receipt = receipt;
+      events.emplace_back(move(entry.done), event);
+      wheel.cancel(entry);
+      entries.erase(it);
+   }
+   deliver(events);
+}
@@ -0,0 +1,85 @@
+/*
+ * receipts.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PUSHOVER_RECEIPTS_H_
+#define PUSHOVER_RECEIPTS_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "pushover.h"
+#include "timerwheel.h"
+
+/** @brief Follows the open emergency receipts
+ *
+ * Every receipt is polled at its own cadence through the shared Pushover client and ends
+ * with exactly one event: acknowledged or expired (request Poll) or cancelled (request Cancel).
+ * The polls are timers of a hierarchical wheel, so thousands of open receipts cost O(1) per tick.
+ */
+class ReceiptTracker {
+public:
+   typedef std::chrono::steady_clock clock;
+
+   /** @param tick resolution of the cadences */
+   explicit ReceiptTracker(Pushover& pushover, clock::duration tick = std::chrono::milliseconds(100));
+   /** @brief Stop polling and wait for the polls in flight */
+   ~ReceiptTracker();
+   ReceiptTracker(const ReceiptTracker&) = delete;
+   ReceiptTracker& operator=(const ReceiptTracker&) = delete;
+
+   /** @brief Follow a receipt
+    * @param receipt receipt of the emergency
+    * @param token the pushover.net application token
+    * @param cadence delay between two polls
+    * @param expire the pushover.net expire parameter, the receipt expires locally if the API did not tell
+    * @param done receives the final event, on the dispatcher or tracker thread
+    */
+   void track(const std::string& receipt, const std::string& token, clock::duration cadence, clock::duration expire,
+         PushoverCallback done);
+   /** @brief Report an acknowledgement received by other means, e.g. the callback URL
+    * @return false if the receipt is not open
+    */
+   bool acknowledge(const std::string& receipt);
+   /** @brief Cancel the emergency at pushover.net and stop following it */
+   void cancel(const std::string& receipt);
+   /** @brief Stop following a receipt without an event, the emergency stays open at pushover.net */
+   void release(const std::string& receipt);
+   /** @brief Number of open receipts */
+   size_t size() const;
+
+private:
+   struct Entry: TimerWheel::Timer {
+      std::string receipt;
+      std::string token;
+      uint64_t cadence;   ///< ticks between two polls
+      uint64_t deadline;  ///< tick the receipt expires locally
+      PushoverCallback done;
+      bool polling = false;
+   };
+
+   uint64_t ticks(clock::duration d) const;
+   void run();
+   void fire(Entry& entry, std::vector<std::pair<PushoverCallback, PushoverResult>>& events);
+   void polled(const std::string& receipt, const PushoverResult& result);
+
+   Pushover& pushover;
+   const clock::duration tick;
+   const clock::time_point start;
+   mutable std::mutex mutex;
+   std::condition_variable wake;
+   std::unordered_map<std::string, std::unique_ptr<Entry>> entries;
+   TimerWheel wheel;
+   int inFlight = 0;  ///< polls not answered yet
+   bool running = true;
+   std::thread thread;
+};
+
+#endif /* PUSHOVER_RECEIPTS_H_ */
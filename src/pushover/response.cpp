@@ -0,0 +1,123 @@
+/*
+ * response.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "response.h"
+
+#include "rapidjson/reader.h"
+
+namespace {
+
+/** @brief SAX handler picking the fields of PushoverResponse */
+class ResponseHandler {
+public:
+   explicit ResponseHandler(PushoverResponse& response) :
+         out(response) {
+   }
+
+   bool Null() { return value(); }
+   bool Bool(bool b) { return number(b ? 1 : 0); }
+   bool Int(int i) { return number(i); }
+   bool Uint(unsigned u) { return number((int64_t) u); }
+   bool Int64(int64_t i) { return number(i); }
+   bool Uint64(uint64_t u) { return number((int64_t) u); }
+   bool Double(double) { return value(); }
+   bool RawNumber(const char*, rapidjson::SizeType, bool) { return value(); }
+   bool String(const char* str, rapidjson::SizeType length, bool) {
+      if (depth == 1 && field == Receipt) {
+         copy(out.receipt, sizeof(out.receipt), str, length);
+      } else if (depth == 2 && field == Errors && out.errors++ == 0) {
+         copy(out.error, sizeof(out.error), str, length);
+      }
+      return value();
+   }
+   bool StartObject() {
+      ++depth;
+      field = Other;
+      return true;
+   }
+   bool Key(const char* str, rapidjson::SizeType length, bool) {
+      field = Other;
+      if (depth == 1) {
+         if (is(str, length, "status")) {
+            field = Status;
+         } else if (is(str, length, "receipt")) {
+            field = Receipt;
+         } else if (is(str, length, "acknowledged")) {
+            field = Acknowledged;
+         } else if (is(str, length, "expired")) {
+            field = Expired;
+         } else if (is(str, length, "errors")) {
+            field = Errors;
+         }
+      }
+      return true;
+   }
+   bool EndObject(rapidjson::SizeType) {
+      --depth;
+      return true;
+   }
+   bool StartArray() {
+      ++depth;
+      return true;
+   }
+   bool EndArray(rapidjson::SizeType) {
+      --depth;
+      return value();
+   }
+
+private:
+   enum Field {
+      Other, Status, Receipt, Acknowledged, Expired, Errors
+   };
+
+   static bool is(const char* str, rapidjson::SizeType length, const char* name) {
+      return strlen(name) == length && memcmp(str, name, length) == 0;
+   }
+   static void copy(char* dst, size_t size, const char* str, rapidjson::SizeType length) {
+      size_t n = length < size ? length : size - 1;
+      memcpy(dst, str, n);
+      dst[n] = 0;
+   }
+   bool number(int64_t i) {
+      if (depth == 1) {
+         if (field == Status) {
+            out.status = (int) i;
+         } else if (field == Acknowledged) {
+            out.acknowledged = (int) i;
+         } else if (field == Expired) {
+            out.expired = (int) i;
+         }
+      }
+      return value();
+   }
+   /** @brief A top level value is complete, the next one needs its own key */
+   bool value() {
+      if (depth == 1) {
+         field = Other;
+      }
+      return true;
+   }
+
+   PushoverResponse& out;
+   int depth = 0;
+   Field field = Other;
+};
+
+} // namespace
+
+bool parse_response(char* json, PushoverResponse& response) {
+   response = PushoverResponse();
+   if (!json || *json == 0) {
+      return false;
+   }
+   ResponseHandler handler(response);
+   rapidjson::InsituStringStream stream(json);
+   rapidjson::Reader reader;
+   return !reader.Parse<rapidjson::kParseInsituFlag>(stream, handler).IsError();
+}
@@ -0,0 +1,33 @@
+/*
+ * response.h
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ */
+
+#ifndef PUSHOVER_RESPONSE_H_
+#define PUSHOVER_RESPONSE_H_
+
+#include <stddef.h>
+
+/** @brief The fields of a pushover.net response used by plcwatchd */
+struct PushoverResponse {
+   int status = -1;        ///< 1 on success, -1 if missing
+   int acknowledged = 0;   ///< receipt poll: 1 if acknowledged
+   int expired = 0;        ///< receipt poll: 1 if expired
+   char receipt[64] = { }; ///< emergency push: receipt, empty if missing
+   int errors = 0;         ///< number of entries of the errors array
+   char error[128] = { };  ///< first entry of the errors array
+};
+
+/** @brief Parse a response in place with a SAX handler, without building a DOM
+ *
+ * Only the top level fields above are extracted, everything else is skipped. No memory is
+ * allocated, the buffer is modified by the in-situ parsing.
+ * @param json null terminated response body
+ * @param response extracted fields
+ * @return false if json is no valid JSON
+ */
+bool parse_response(char* json, PushoverResponse& response);
+
+#endif /* PUSHOVER_RESPONSE_H_ */
@@ -0,0 +1,478 @@
+/*
+ * pushovermock.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ *
+ * Local stand-in for the pushover.net API to test and benchmark the notification path offline.
+ * Implements messages.json, receipts/<receipt>.json and receipts/<receipt>/cancel.json with a
+ * configurable latency, error rate and acknowledge delay. Emergencies with a callback URL get
+ * the acknowledgement POSTed there. Messages use up a monthly quota reported in the X-Limit-App-*
+ * headers like the real API. Point plcwatchd at it with -A http://localhost:<port>/1.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <curl/curl.h>
+#include "http.h"
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+static const size_t maxRequest = 65536;
+
+/** @brief Behaviour of the mock */
+struct Options {
+   int port = 8081;
+   chrono::milliseconds latency { 0 };  ///< delay of every answer
+   chrono::milliseconds jitter { 0 };   ///< random extra delay, 0..jitter
+   double errorRate = 0;                ///< share of requests failing with 500
+   chrono::milliseconds ackDelay { 2000 }; ///< emergency acknowledged after this delay, negative for never
+   long quota = 10000;                  ///< messages per month, the free limit of pushover.net
+   bool verbose = false;
+};
+
+/** @brief An emergency sent with priority 2 */
+struct Receipt {
+   Clock::time_point ackAt;
+   time_t created;
+   long expire;
+   string callback;
+   bool cancelled = false;
+   bool calledBack = false;
+};
+
+struct Connection {
+   int fd;
+   string in;
+   bool busy = false;   ///< answer scheduled, the next request waits
+};
+
+/** @brief Answer sent once due */
+struct Answer {
+   uint64_t connection;
+   string data;
+   bool close;
+};
+
+struct Stats {
+   unsigned long messages = 0;
+   unsigned long emergencies = 0;
+   unsigned long polls = 0;
+   unsigned long cancels = 0;
+   unsigned long callbacks = 0;
+   unsigned long errors = 0;
+   unsigned long rejected = 0;  ///< messages over quota
+};
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int) {
+   running = 0;
+}
+
+class Mock {
+public:
+   explicit Mock(const Options& options) :
+         opt(options), random(random_device()()), multi(curl_multi_init()), remaining(options.quota) {
+      // the quota is reset at the start of the next month
+      time_t now = time(NULL);
+      struct tm t;
+      localtime_r(&now, &t);
+      t.tm_mday = 1;
+      t.tm_hour = t.tm_min = t.tm_sec = 0;
+      ++t.tm_mon;
+      t.tm_isdst = -1;
+      reset = mktime(&t);
+   }
+   ~Mock() {
+      for (auto& c : posting) {
+         curl_multi_remove_handle(multi, c.first);
+         curl_easy_cleanup(c.first);
+      }
+      curl_multi_cleanup(multi);
+   }
+   Mock(const Mock&) = delete;
+   Mock& operator=(const Mock&) = delete;
+
+   bool listen() {
+      listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      int on = 1;
+      struct sockaddr_in addr = {};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_ANY);
+      addr.sin_port = htons((uint16_t) opt.port);
+      if (listenFd < 0 || setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0
+            || bind(listenFd, (struct sockaddr*) &addr, sizeof(addr)) < 0 || ::listen(listenFd, 128) < 0) {
+         cerr << "pushover-mock: unable to listen on port " << opt.port << ": " << strerror(errno) << endl;
+         return false;
+      }
+      cout << "pushover-mock: listening on http://localhost:" << opt.port << "/1" << endl;
+      return true;
+   }
+
+   void run() {
+      // the callbacks are transfers of the multi handle, its poll waits for them and the sockets of the mock
+      vector<struct curl_waitfd> fds;
+      vector<uint64_t> ids;
+      while (running) {
+         Clock::time_point now = Clock::now();
+         send_due(now);
+         call_back(now);
+         called_back();
+
+         fds.clear();
+         ids.clear();
+         fds.push_back( { listenFd, CURL_WAIT_POLLIN, 0 });
+         for (const auto& c : connections) {
+            fds.push_back( { c.second.fd, (short) (c.second.busy ? 0 : CURL_WAIT_POLLIN), 0 });
+            ids.push_back(c.first);
+         }
+         if (curl_multi_poll(multi, fds.data(), fds.size(), timeout(now), NULL) != CURLM_OK) {
+            continue;
+         }
+         for (size_t i = 1; i < fds.size(); ++i) {
+            if (fds[i].revents) {
+               receive(ids[i - 1]);
+            }
+         }
+         if (fds[0].revents & CURL_WAIT_POLLIN) {
+            int fd;
+            while ((fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+               connections[nextId++] = Connection { fd, string(), false };
+            }
+         }
+      }
+      cout << "pushover-mock: " << stats.messages << " messages, " << stats.emergencies << " emergencies, "
+            << stats.polls << " receipt polls, " << stats.cancels << " cancels, " << stats.callbacks
+            << " callbacks, " << stats.errors << " injected errors, " << stats.rejected << " over quota" << endl;
+   }
+
+private:
+   /** @return poll timeout in ms until the next answer or callback is due */
+   int timeout(Clock::time_point now) const {
+      Clock::time_point next = now + chrono::seconds(1);
+      if (!answers.empty()) {
+         next = min(next, answers.begin()->first);
+      }
+      if (!callbacks.empty()) {
+         next = min(next, callbacks.begin()->first);
+      }
+      return (int) max<long>(0, chrono::duration_cast<chrono::milliseconds>(next - now + chrono::microseconds(999)).count());
+   }
+
+   void receive(uint64_t id) {
+      Connection& c = connections[id];
+      char buffer[4096];
+      ssize_t n = recv(c.fd, buffer, sizeof(buffer), 0);
+      if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+         return;
+      }
+      if (n <= 0) {
+         drop(id);
+         return;
+      }
+      c.in.append(buffer, n);
+
+      http::Request request;
+      switch (http::parse(c.in, request, maxRequest)) {
+      case http::Incomplete:
+         return;
+      case http::TooLarge:
+         schedule(id, http::response(413, string(), false), true);
+         return;
+      case http::Invalid:
+         schedule(id, http::response(400, string(), false), true);
+         return;
+      default:
+         schedule(id, handle(request), !request.keepAlive);
+         return;
+      }
+   }
+
+   void schedule(uint64_t id, const string& data, bool close) {
+      Connection& c = connections[id];
+      c.busy = true;
+      chrono::milliseconds delay = opt.latency;
+      if (opt.jitter.count() > 0) {
+         delay += chrono::milliseconds(uniform_int_distribution<long>(0, opt.jitter.count())(random));
+      }
+      answers.emplace(Clock::now() + delay, Answer { id, data, close });
+   }
+
+   void send_due(Clock::time_point now) {
+      while (!answers.empty() && answers.begin()->first <= now) {
+         Answer answer = answers.begin()->second;
+         answers.erase(answers.begin());
+         auto it = connections.find(answer.connection);
+         if (it == connections.end()) {
+            continue;
+         }
+         // answers are small, retrying a full socket buffer is fine for a mock
+         int fd = it->second.fd;
+         size_t sent = 0;
+         while (sent < answer.data.size()) {
+            ssize_t n = send(fd, answer.data.data() + sent, answer.data.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno != EAGAIN && errno != EINTR) {
+               break;
+            }
+            sent += n > 0 ? n : 0;
+         }
+         it->second.busy = false;
+         if (answer.close || sent < answer.data.size()) {
+            drop(answer.connection);
+         } else if (!it->second.in.empty()) {
+            // pipelined request already in the buffer
+            http::Request request;
+            if (http::parse(it->second.in, request, maxRequest) == http::Complete) {
+               schedule(answer.connection, handle(request), !request.keepAlive);
+            }
+         }
+      }
+   }
+
+   void drop(uint64_t id) {
+      auto it = connections.find(id);
+      if (it != connections.end()) {
+         close(it->second.fd);
+         connections.erase(it);
+      }
+   }
+
+   string request_id() {
+      static const char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+      uniform_int_distribution<int> pick(0, sizeof(chars) - 2);
+      string id(30, ' ');
+      for (char& c : id) {
+         c = chars[pick(random)];
+      }
+      return id;
+   }
+
+   static string error(const string& text, const string& request) {
+      return "{\"errors\":[\"" + text + "\"],\"status\":0,\"request\":\"" + request + "\"}";
+   }
+
+   /** @return complete HTTP answer */
+   string handle(const http::Request& request) {
+      string id = request_id();
+      if (opt.errorRate > 0 && uniform_real_distribution<double>(0, 1)(random) < opt.errorRate) {
+         ++stats.errors;
+         return http::response(500, error("pushover-mock: injected failure", id), request.keepAlive);
+      }
+
+      string path = request.target.substr(0, request.target.find('?'));
+      string query = request.target.size() > path.size() ? request.target.substr(path.size() + 1) : string();
+      int status = 200;
+      string body;
+      string headers;
+      if (path == "/1/messages.json" && request.method == "POST") {
+         body = message(request.body, id, status);
+         headers = "X-Limit-App-Limit: " + to_string(opt.quota) + "\r\nX-Limit-App-Remaining: " + to_string(remaining)
+               + "\r\nX-Limit-App-Reset: " + to_string(reset) + "\r\n";
+      } else if (path.compare(0, 12, "/1/receipts/") == 0 && path.size() > 29
+            && path.compare(path.size() - 12, 12, "/cancel.json") == 0 && request.method == "POST") {
+         body = cancel(path.substr(12, path.size() - 24), id, status);
+      } else if (path.compare(0, 12, "/1/receipts/") == 0 && path.size() > 17
+            && path.compare(path.size() - 5, 5, ".json") == 0 && request.method == "GET") {
+         body = receipt(path.substr(12, path.size() - 17), id, status);
+      } else {
+         status = 404;
+         body = error("unknown endpoint " + request.method + " " + path, id);
+      }
+      if (opt.verbose) {
+         cout << request.method << " " << path << " -> " << status << endl;
+      }
+      return http::response(status, body, request.keepAlive, headers);
+   }
+
+   string message(const string& form, const string& id, int& status) {
+      ++stats.messages;
+      if (http::form_field(form, "token").empty() || http::form_field(form, "user").empty()) {
+         status = 400;
+         return error("token and user are required", id);
+      }
+      if (remaining <= 0) {
+         ++stats.rejected;
+         status = 429;
+         return error("application is over its monthly message limit", id);
+      }
+      --remaining;
+      if (http::form_field(form, "priority") != "2") {
+         return "{\"status\":1,\"request\":\"" + id + "\"}";
+      }
+      ++stats.emergencies;
+      string r = request_id();
+      Receipt& e = receipts[r];
+      e.ackAt = opt.ackDelay.count() < 0 ? Clock::time_point::max() : Clock::now() + opt.ackDelay;
+      e.created = time(NULL);
+      e.expire = atol(http::form_field(form, "expire").c_str());
+      e.callback = http::form_field(form, "callback");
+      if (!e.callback.empty() && opt.ackDelay.count() >= 0) {
+         callbacks.emplace(e.ackAt, r);
+      }
+      return "{\"status\":1,\"request\":\"" + id + "\",\"receipt\":\"" + r + "\"}";
+   }
+
+   string receipt(const string& r, const string& id, int& status) {
+      ++stats.polls;
+      auto it = receipts.find(r);
+      if (it == receipts.end()) {
+         status = 404;
+         return error("receipt not found; may be invalid or expired", id);
+      }
+      const Receipt& e = it->second;
+      time_t now = time(NULL);
+      bool acknowledged = !e.cancelled && Clock::now() >= e.ackAt;
+      bool expired = !acknowledged && (e.cancelled || (e.expire > 0 && now >= e.created + e.expire));
+      string ack = acknowledged ? "1" : "0";
+      return "{\"status\":1,\"acknowledged\":" + ack + ",\"acknowledged_at\":" + (acknowledged ? to_string(now) : "0")
+            + ",\"acknowledged_by\":\"" + (acknowledged ? "mock" : "") + "\",\"acknowledged_by_device\":\""
+            + (acknowledged ? "mock" : "") + "\",\"last_delivered_at\":" + to_string(e.created) + ",\"expired\":"
+            + (expired ? "1" : "0") + ",\"expires_at\":" + to_string(e.created + e.expire) + ",\"called_back\":"
+            + (e.calledBack ? "1" : "0") + ",\"called_back_at\":0,\"request\":\"" + id + "\"}";
+   }
+
+   string cancel(const string& r, const string& id, int& status) {
+      ++stats.cancels;
+      auto it = receipts.find(r);
+      if (it == receipts.end()) {
+         status = 404;
+         return error("receipt not found; may be invalid or expired", id);
+      }
+      it->second.cancelled = true;
+      return "{\"status\":1,\"request\":\"" + id + "\"}";
+   }
+
+   /** @brief Start POSTing the due acknowledgements to the callback URLs, the answers never wait for them */
+   void call_back(Clock::time_point now) {
+      while (!callbacks.empty() && callbacks.begin()->first <= now) {
+         string r = callbacks.begin()->second;
+         callbacks.erase(callbacks.begin());
+         Receipt& e = receipts[r];
+         if (e.cancelled) {
+            continue;
+         }
+         string form = "receipt=" + r + "&acknowledged=1&acknowledged_at=" + to_string(time(NULL))
+               + "&acknowledged_by=mock&acknowledged_by_device=mock";
+         CURL* curl = curl_easy_init();
+         if (curl) {
+            curl_easy_setopt(curl, CURLOPT_URL, e.callback.c_str());
+            curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, form.c_str());
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 2L);
+            curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+            curl_multi_add_handle(multi, curl);
+            posting[curl] = r;
+         }
+      }
+      int transfers;
+      curl_multi_perform(multi, &transfers);
+   }
+
+   /** @brief Pick up the finished callbacks */
+   void called_back() {
+      int pending;
+      while (CURLMsg* msg = curl_multi_info_read(multi, &pending)) {
+         if (msg->msg != CURLMSG_DONE) {
+            continue;
+         }
+         CURL* curl = msg->easy_handle;
+         CURLcode res = msg->data.result;
+         long code = 0;
+         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+         Receipt& e = receipts[posting[curl]];
+         if (opt.verbose || res != CURLE_OK) {
+            cout << "callback " << e.callback << " -> " << (res == CURLE_OK ? to_string(code) : curl_easy_strerror(res))
+                  << endl;
+         }
+         e.calledBack = res == CURLE_OK;
+         ++stats.callbacks;
+         posting.erase(curl);
+         curl_multi_remove_handle(multi, curl);
+         curl_easy_cleanup(curl);
+      }
+   }
+
+   Options opt;
+   mt19937 random;
+   int listenFd = -1;
+   uint64_t nextId = 0;
+   map<uint64_t, Connection> connections;
+   multimap<Clock::time_point, Answer> answers;
+   multimap<Clock::time_point, string> callbacks;
+   CURLM* multi;
+   map<CURL*, string> posting;  ///< callbacks on their way, by receipt
+   unordered_map<string, Receipt> receipts;
+   long remaining;  ///< messages left of the quota
+   time_t reset;    ///< end of the month
+   Stats stats;
+};
+
+static void usage() {
+   cout << "Usage: pushover-mock [-p port] [-l ms] [-j ms] [-e rate] [-a ms] [-q num] [-v]" << endl << endl
+         << "  -p   port to listen on, default 8081" << endl
+         << "  -l   latency of every answer in ms, default 0" << endl
+         << "  -j   random extra latency up to ms, default 0" << endl
+         << "  -e   share of requests failing with HTTP 500, 0..1, default 0" << endl
+         << "  -a   emergencies are acknowledged after ms, -1 for never, default 2000" << endl
+         << "  -q   messages per month, default 10000" << endl
+         << "  -v   log every request" << endl;
+}
+
+int main(int argc, char *argv[]) {
+   Options opt;
+   int option;
+   while ((option = getopt(argc, argv, "p:l:j:e:a:q:vh")) != -1) {
+      switch (option) {
+      case 'p':
+         opt.port = atoi(optarg);
+         break;
+      case 'l':
+         opt.latency = chrono::milliseconds(atol(optarg));
+         break;
+      case 'j':
+         opt.jitter = chrono::milliseconds(atol(optarg));
+         break;
+      case 'e':
+         opt.errorRate = atof(optarg);
+         break;
+      case 'a':
+         opt.ackDelay = chrono::milliseconds(atol(optarg));
+         break;
+      case 'q':
+         opt.quota = atol(optarg);
+         break;
+      case 'v':
+         opt.verbose = true;
+         break;
+      default:
+         usage();
+         return EXIT_FAILURE;
+      }
+   }
+
+   signal(SIGINT, &stop);
+   signal(SIGTERM, &stop);
+   curl_global_init(CURL_GLOBAL_ALL);
+   Mock mock(opt);
+   if (!mock.listen()) {
+      return EXIT_FAILURE;
+   }
+   mock.run();
+   curl_global_cleanup();
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,698 @@
+/*
+ * s7dbgen.cpp
+ *
+ *  Created on: 17.10.2026
+ *      Author: CBe
+ *
+ * Generate C++ layouts of S7 data blocks from the sources exported by TIA Portal
+ * ("Generate source from blocks", *.db and *.udt). Every UDT and DB becomes a struct with
+ * typed members, a constexpr offset table and a decode() function reading the members from
+ * the big endian DB image at fixed offsets, see s7layout.h.
+ *
+ * Only DBs with standard (not optimized) block access have a fixed layout and can be read
+ * with DBRead().
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/** @brief Error in a source file, reported as file:line: message */
+struct SourceError {
+   string message;
+};
+
+//---------------------------------------------------------------------------
+// Lexer
+//---------------------------------------------------------------------------
+enum class Tok {
+   Ident, Name, Text, Number, Symbol, End
+};
+
+struct Token {
+   Tok kind;
+   string text;
+   int line;
+};
+
+class Lexer {
+public:
+   Lexer(const string& source, const string& file) :
+         src(source), file(file) {
+      next();
+   }
+
+   const Token& peek() const { return tok; }
+
+   Token take() {
+      Token t = tok;
+      next();
+      return t;
+   }
+
+   bool is(const char* text) const {
+      return (tok.kind == Tok::Ident || tok.kind == Tok::Symbol) && strcasecmp(tok.text.c_str(), text) == 0;
+   }
+
+   bool accept(const char* text) {
+      if (!is(text)) {
+         return false;
+      }
+      next();
+      return true;
+   }
+
+   void expect(const char* text) {
+      if (!accept(text)) {
+         fail(string("expected '") + text + "' but found '" + tok.text + "'");
+      }
+   }
+
+   [[noreturn]] void fail(const string& message) const {
+      throw SourceError { file + ":" + to_string(tok.line) + ": " + message };
+   }
+
+private:
+   void next() {
+      skip();
+      tok.line = line;
+      tok.text.clear();
+      if (pos >= src.size()) {
+         tok.kind = Tok::End;
+         return;
+      }
+      char c = src[pos];
+      if (isalpha((unsigned char) c) || c == '_' || c == '#') {
+         tok.kind = Tok::Ident;
+         while (pos < src.size() && (isalnum((unsigned char) src[pos]) || src[pos] == '_' || src[pos] == '#')) {
+            tok.text += src[pos++];
+         }
+      } else if (isdigit((unsigned char) c)) {
+         tok.kind = Tok::Number;
+         while (pos < src.size() && (isalnum((unsigned char) src[pos])
+               || (src[pos] == '.' && pos + 1 < src.size() && isdigit((unsigned char) src[pos + 1])))) {
+            tok.text += src[pos++];
+         }
+      } else if (c == '"' || c == '\'') {
+         tok.kind = c == '"' ? Tok::Name : Tok::Text;
+         ++pos;
+         while (pos < src.size() && src[pos] != c) {
+            line += src[pos] == '\n';
+            tok.text += src[pos++];
+         }
+         ++pos;
+      } else {
+         tok.kind = Tok::Symbol;
+         static const char* pairs[] = { ":=", "..", nullptr };
+         for (const char** p = pairs; *p; ++p) {
+            if (src.compare(pos, 2, *p) == 0) {
+               tok.text = *p;
+               pos += 2;
+               return;
+            }
+         }
+         tok.text = c;
+         ++pos;
+      }
+   }
+
+   void skip() {
+      while (pos < src.size()) {
+         if (src[pos] == '\n') {
+            ++line;
+            ++pos;
+         } else if (isspace((unsigned char) src[pos])) {
+            ++pos;
+         } else if (src.compare(pos, 2, "//") == 0) {
+            pos = src.find('\n', pos);
+            pos = pos == string::npos ? src.size() : pos;
+         } else if (src.compare(pos, 2, "(*") == 0) {
+            size_t end = src.find("*)", pos);
+            end = end == string::npos ? src.size() : end + 2;
+            for (; pos < end; ++pos) {
+               line += src[pos] == '\n';
+            }
+         } else {
+            break;
+         }
+      }
+   }
+
+   const string& src;
+   string file;
+   size_t pos = 0;
+   int line = 1;
+   Token tok;
+};
+
+//---------------------------------------------------------------------------
+// Syntax tree
+//---------------------------------------------------------------------------
+struct Type;
+
+struct Member {
+   string name;
+   shared_ptr<Type> type;
+};
+
+struct Type {
+   enum Kind {
+      Elementary, String, Struct, Udt, Array
+   } kind;
+   string name;               ///< elementary type or UDT name
+   int length = 0;            ///< STRING length
+   int low = 0, high = 0;     ///< ARRAY bounds
+   shared_ptr<Type> element;  ///< ARRAY element
+   vector<Member> members;    ///< STRUCT members
+};
+
+struct Block {
+   bool db;                   ///< DATA_BLOCK or TYPE
+   string name;
+   shared_ptr<Type> type;     ///< Struct or Udt
+   string file;
+};
+
+/** @brief C++ type, size in bytes (0 for Bool) of the elementary S7 types */
+static const map<string, pair<const char*, int>> elementary = {
+   { "BOOL", { "bool", 0 } }, { "BYTE", { "uint8_t", 1 } }, { "CHAR", { "char", 1 } },
+   { "SINT", { "int8_t", 1 } }, { "USINT", { "uint8_t", 1 } }, { "WORD", { "uint16_t", 2 } },
+   { "INT", { "int16_t", 2 } }, { "UINT", { "uint16_t", 2 } }, { "WCHAR", { "uint16_t", 2 } },
+   { "S5TIME", { "uint16_t", 2 } }, { "DATE", { "uint16_t", 2 } }, { "DWORD", { "uint32_t", 4 } },
+   { "DINT", { "int32_t", 4 } }, { "UDINT", { "uint32_t", 4 } }, { "REAL", { "float", 4 } },
+   { "TIME", { "int32_t", 4 } }, { "TIME_OF_DAY", { "uint32_t", 4 } }, { "TOD", { "uint32_t", 4 } },
+   { "LREAL", { "double", 8 } }, { "LWORD", { "uint64_t", 8 } }, { "LINT", { "int64_t", 8 } },
+   { "ULINT", { "uint64_t", 8 } }, { "DATE_AND_TIME", { "uint64_t", 8 } }, { "DT", { "uint64_t", 8 } },
+};
+
+static string upper(string s) {
+   for (char& c : s) {
+      c = toupper((unsigned char) c);
+   }
+   return s;
+}
+
+//---------------------------------------------------------------------------
+// Parser
+//---------------------------------------------------------------------------
+class Parser {
+public:
+   Parser(Lexer& lexer, const string& file) :
+         lex(lexer), file(file) {
+   }
+
+   void parse(vector<Block>& blocks) {
+      while (lex.peek().kind != Tok::End) {
+         if (lex.accept("TYPE")) {
+            Block block { false, name(), nullptr, file };
+            header();
+            block.type = structure();
+            lex.accept(";");
+            lex.expect("END_TYPE");
+            blocks.push_back(block);
+         } else if (lex.accept("DATA_BLOCK")) {
+            Block block { true, name(), nullptr, file };
+            header();
+            if (lex.peek().kind == Tok::Name) {
+               block.type = make_shared<Type>();
+               block.type->kind = Type::Udt;
+               block.type->name = lex.take().text;
+            } else {
+               block.type = structure();
+            }
+            // initial values are not part of the layout
+            while (!lex.accept("END_DATA_BLOCK")) {
+               if (lex.take().kind == Tok::End) {
+                  lex.fail("missing END_DATA_BLOCK");
+               }
+            }
+            blocks.push_back(block);
+         } else if (lex.peek().kind == Tok::Symbol) {
+            lex.take();
+         } else {
+            lex.fail("expected TYPE or DATA_BLOCK but found '" + lex.peek().text + "'");
+         }
+      }
+   }
+
+private:
+   string name() {
+      if (lex.peek().kind != Tok::Name && lex.peek().kind != Tok::Ident) {
+         lex.fail("expected a name");
+      }
+      return lex.take().text;
+   }
+
+   /** @brief Skip title, attributes, version and retain flags up to the declaration */
+   void header() {
+      while (!lex.is("STRUCT") && lex.peek().kind != Tok::Name) {
+         if (lex.is("{")) {
+            attributes();
+         } else if (lex.take().kind == Tok::End) {
+            lex.fail("missing STRUCT");
+         }
+      }
+   }
+
+   /** @brief Skip an attribute block, reject optimized block access */
+   void attributes() {
+      lex.expect("{");
+      while (!lex.accept("}")) {
+         Token t = lex.take();
+         if (t.kind == Tok::End) {
+            lex.fail("missing '}'");
+         }
+         if (t.kind == Tok::Ident && strcasecmp(t.text.c_str(), "S7_Optimized_Access") == 0 && lex.accept(":=")
+               && lex.peek().kind == Tok::Text && strcasecmp(lex.peek().text.c_str(), "TRUE") == 0) {
+            lex.fail("optimized block access has no fixed layout, disable it to read the DB with DBRead()");
+         }
+      }
+   }
+
+   shared_ptr<Type> structure() {
+      lex.expect("STRUCT");
+      shared_ptr<Type> type = make_shared<Type>();
+      type->kind = Type::Struct;
+      while (!lex.accept("END_STRUCT")) {
+         Member m;
+         m.name = name();
+         if (lex.is("{")) {
+            attributes();
+         }
+         lex.expect(":");
+         m.type = declaration();
+         if (lex.accept(":=")) {
+            while (!lex.is(";")) {
+               if (lex.take().kind == Tok::End) {
+                  lex.fail("missing ';'");
+               }
+            }
+         }
+         lex.expect(";");
+         type->members.push_back(m);
+      }
+      return type;
+   }
+
+   int integer() {
+      bool negative = lex.accept("-");
+      if (lex.peek().kind != Tok::Number) {
+         lex.fail("expected a number");
+      }
+      int v = atoi(lex.take().text.c_str());
+      return negative ? -v : v;
+   }
+
+   shared_ptr<Type> declaration() {
+      if (lex.is("STRUCT")) {
+         return structure();
+      }
+      shared_ptr<Type> type = make_shared<Type>();
+      if (lex.peek().kind == Tok::Name) {
+         type->kind = Type::Udt;
+         type->name = lex.take().text;
+      } else if (lex.accept("ARRAY")) {
+         type->kind = Type::Array;
+         lex.expect("[");
+         type->low = integer();
+         lex.expect("..");
+         type->high = integer();
+         if (lex.is(",")) {
+            lex.fail("multi-dimensional arrays are not supported");
+         }
+         lex.expect("]");
+         lex.expect("OF");
+         if (type->high < type->low) {
+            lex.fail("empty array");
+         }
+         type->element = declaration();
+      } else if (lex.accept("STRING")) {
+         type->kind = Type::String;
+         type->length = 254;
+         if (lex.accept("[")) {
+            type->length = integer();
+            lex.expect("]");
+         }
+         if (type->length < 1 || type->length > 254) {
+            lex.fail("invalid STRING length");
+         }
+      } else {
+         type->kind = Type::Elementary;
+         type->name = upper(name());
+         if (!elementary.count(type->name)) {
+            lex.fail("unsupported type '" + type->name + "'");
+         }
+      }
+      return type;
+   }
+
+   Lexer& lex;
+   string file;
+};
+
+//---------------------------------------------------------------------------
+// Layout and code generation
+//---------------------------------------------------------------------------
+class Generator {
+public:
+   explicit Generator(const vector<Block>& blocks) {
+      for (const Block& b : blocks) {
+         (b.db ? dbs : udts)[b.name] = b;
+      }
+   }
+
+   string generate(const string& ns, const string& guard) {
+      out << "// generated by s7dbgen, do not edit\n\n"
+            << "#ifndef " << guard << "\n#define " << guard << "\n\n"
+            << "#include <stdint.h>\n#include \"s7layout.h\"\n\n"
+            << "namespace " << ns << " {\n";
+      for (const auto& udt : udts) {
+         emit_udt(udt.first);
+      }
+      for (const auto& db : dbs) {
+         const Block& b = db.second;
+         if (b.type->kind == Type::Udt) {
+            udt(b.type->name, b.file);
+            emit_udt(b.type->name);
+            out << "\n/** @brief DB \"" << b.name << "\" of type \"" << b.type->name << "\" */\n"
+                  << "typedef " << ident(b.type->name) << " " << ident(b.name) << ";\n";
+         } else {
+            emit_struct(ident(b.name), *b.type, "DB \"" + b.name + "\"", "", b.file, true);
+         }
+      }
+      out << "\n} // namespace " << ns << "\n\n#endif\n";
+      return out.str();
+   }
+
+private:
+   /** @brief Bit position and size of a laid out member */
+   struct Slot {
+      int bit;       ///< bit offset from the start of the enclosing struct
+      int size;      ///< size in bytes, 0 for Bool
+   };
+
+   static int align_byte(int bit) { return (bit + 7) & ~7; }
+   static int align_word(int bit) { return (bit + 15) & ~15; }
+
+   const Block& udt(const string& name, const string& file) {
+      auto it = udts.find(name);
+      if (it == udts.end()) {
+         throw SourceError { file + ": unknown UDT \"" + name + "\", pass its .udt source as well" };
+      }
+      return it->second;
+   }
+
+   /** @brief Size in bytes of a type, 0 for Bool */
+   int size_of(const Type& type, const string& file) {
+      switch (type.kind) {
+      case Type::Elementary:
+         return elementary.at(type.name).second;
+      case Type::String:
+         return type.length + 2;
+      case Type::Udt:
+         return size_of(*udt(type.name, file).type, file);
+      case Type::Struct: {
+         int bit = 0;
+         for (const Member& m : type.members) {
+            bit = place(*m.type, bit, file).bit;
+            bit += bits_of(*m.type, file);
+            bit = after(*m.type, bit);
+         }
+         return align_word(bit) / 8;
+      }
+      case Type::Array: {
+         int element = size_of(*type.element, file);
+         int count = type.high - type.low + 1;
+         if (element == 0) {
+            return align_byte(count) / 8;
+         }
+         return count * stride(*type.element, file);
+      }
+      }
+      return 0;
+   }
+
+   /** @brief Distance of two array elements in bytes */
+   int stride(const Type& element, const string& file) {
+      int size = size_of(element, file);
+      return (size > 1 && (size & 1)) ? size + 1 : size;
+   }
+
+   int bits_of(const Type& type, const string& file) {
+      int size = size_of(type, file);
+      return size == 0 ? 1 : size * 8;
+   }
+
+   /** @brief Align the start of a member */
+   Slot place(const Type& type, int bit, const string& file) {
+      int size = size_of(type, file);
+      if (type.kind == Type::Elementary && size == 0) {
+         return Slot { bit, 0 };
+      }
+      if (type.kind == Type::Elementary && size == 1) {
+         return Slot { align_byte(bit), 1 };
+      }
+      return Slot { align_word(bit), size };
+   }
+
+   /** @brief Arrays and structs are followed by a word boundary */
+   static int after(const Type& type, int bit) {
+      return (type.kind == Type::Array || type.kind == Type::Struct || type.kind == Type::Udt) ? align_word(bit) : bit;
+   }
+
+   static string ident(const string& name) {
+      static const set<string> keywords = { "auto", "bool", "break", "case", "char", "class", "const", "default",
+            "delete", "do", "double", "else", "enum", "float", "for", "goto", "if", "int", "long", "namespace", "new",
+            "operator", "private", "protected", "public", "return", "short", "signed", "size", "sizeof", "static",
+            "struct", "switch", "template", "this", "typedef", "union", "unsigned", "void", "volatile", "while",
+            "layout", "decode", "load" };
+      string id;
+      for (char c : name) {
+         id += isalnum((unsigned char) c) ? c : '_';
+      }
+      if (id.empty() || isdigit((unsigned char) id[0]) || keywords.count(id)) {
+         id = "_" + id;
+      }
+      return id;
+   }
+
+   /** @brief C++ type of a member, nested structs are emitted by the caller */
+   string cpp_type(const Type& type, const string& member) {
+      switch (type.kind) {
+      case Type::Elementary:
+         return elementary.at(type.name).first;
+      case Type::String:
+         return "s7::String<" + to_string(type.length) + ">";
+      case Type::Udt:
+         return ident(type.name);
+      case Type::Struct:
+         return member + "_t";
+      case Type::Array:
+         return cpp_type(*type.element, member);
+      }
+      return "";
+   }
+
+   void emit_udt(const string& name) {
+      if (emitted.count(name)) {
+         return;
+      }
+      if (!active.insert(name).second) {
+         throw SourceError { udts[name].file + ": UDT \"" + name + "\" contains itself" };
+      }
+      const Block& b = udts[name];
+      emit_dependencies(*b.type, b.file);
+      emit_struct(ident(name), *b.type, "UDT \"" + name + "\"", "", b.file, false);
+      active.erase(name);
+      emitted.insert(name);
+   }
+
+   void emit_dependencies(const Type& type, const string& file) {
+      if (type.kind == Type::Udt) {
+         udt(type.name, file);
+         emit_udt(type.name);
+      } else if (type.kind == Type::Array) {
+         emit_dependencies(*type.element, file);
+      } else if (type.kind == Type::Struct) {
+         for (const Member& m : type.members) {
+            emit_dependencies(*m.type, file);
+         }
+      }
+   }
+
+   /** @brief Emit the load of a value at byte expression p, bit expression bit */
+   string load(const Type& type, const string& target, const string& p, const string& bit) {
+      if (type.kind == Type::Elementary && elementary.at(type.name).second == 0) {
+         return target + " = s7::load_bit(" + p + ", " + bit + ");";
+      }
+      if (type.kind == Type::Elementary) {
+         return target + " = s7::load<" + elementary.at(type.name).first + ">(" + p + ");";
+      }
+      return target + ".load(" + p + ");";
+   }
+
+   /** @brief Emit the struct of a UDT, DB or nested STRUCT
+    * @param db true for a DB, its size is not padded to a word, a DBRead() beyond the DB fails
+    */
+   void emit_struct(const string& name, const Type& type, const string& what, const string& indent, const string& file,
+         bool db) {
+      for (const Member& m : type.members) {
+         emit_dependencies(*m.type, file);
+      }
+      int size = size_of(type, file);
+      if (db && !type.members.empty()) {
+         Slot last { 0, 0 };
+         int end = 0;
+         for (const Member& m : type.members) {
+            last = place(*m.type, end, file);
+            end = after(*m.type, last.bit + bits_of(*m.type, file));
+         }
+         size = align_byte(last.bit + bits_of(*type.members.back().type, file)) / 8;
+      }
+      out << "\n" << indent << "/** @brief " << what << ", " << size << " bytes */\n"
+            << indent << "struct " << name << " {\n";
+
+      // nested structs and members
+      vector<Slot> slots;
+      int bit = 0;
+      for (const Member& m : type.members) {
+         string id = ident(m.name);
+         const Type* t = m.type.get();
+         if (t->kind == Type::Array) {
+            t = t->element.get();
+         }
+         if (t->kind == Type::Struct) {
+            emit_struct(id + "_t", *t, "STRUCT " + m.name, indent + "   ", file, false);
+         }
+         Slot slot = place(*m.type, bit, file);
+         slots.push_back(slot);
+         bit = after(*m.type, slot.bit + bits_of(*m.type, file));
+
+         out << indent << "   " << cpp_type(*m.type, id) << " " << id;
+         if (m.type->kind == Type::Array) {
+            out << "[" << (m.type->high - m.type->low + 1) << "]; ///< ARRAY[" << m.type->low << ".."
+                  << m.type->high << "]\n";
+         } else {
+            out << ";\n";
+         }
+      }
+
+      // offset table
+      out << "\n" << indent << "   static constexpr int size = " << size << ";\n"
+            << indent << "   /** @brief Offsets of the members */\n"
+            << indent << "   struct layout {\n";
+      for (size_t i = 0; i < type.members.size(); ++i) {
+         out << indent << "      static constexpr s7::Field " << ident(type.members[i].name) << " = { "
+               << slots[i].bit / 8 << ", " << slots[i].bit % 8 << " };\n";
+      }
+      out << indent << "   };\n\n";
+
+      // decoder
+      out << indent << "   /** @brief Decode the members from the big endian image starting at p */\n"
+            << indent << "   void decode(const uint8_t* p) {\n";
+      for (const Member& m : type.members) {
+         string id = ident(m.name);
+         string f = "layout::" + id;
+         if (m.type->kind != Type::Array) {
+            out << indent << "      " << load(*m.type, id, "p + " + f + ".byte", f + ".bit") << "\n";
+            continue;
+         }
+         const Type& e = *m.type->element;
+         int count = m.type->high - m.type->low + 1;
+         if (e.kind == Type::Elementary && elementary.at(e.name).second >= 2) {
+            // numeric arrays are byte aligned and packed, swap them in one go
+            out << indent << "      s7::decode(p + " << f << ".byte, " << id << ", " << count << ");\n";
+            continue;
+         }
+         out << indent << "      for (int i = 0; i < " << count << "; ++i) {\n" << indent << "         ";
+         if (e.kind == Type::Elementary && elementary.at(e.name).second == 0) {
+            out << load(e, id + "[i]", "p + " + f + ".byte + (" + f + ".bit + i) / 8", "(" + f + ".bit + i) % 8");
+         } else {
+            out << load(e, id + "[i]", "p + " + f + ".byte + i * " + to_string(stride(e, file)), "0");
+         }
+         out << "\n" << indent << "      }\n";
+      }
+      out << indent << "   }\n";
+      out << indent << "   void load(const uint8_t* p) { decode(p); }\n";
+      out << indent << "};\n";
+   }
+
+   map<string, Block> udts;
+   map<string, Block> dbs;
+   set<string> emitted;
+   set<string> active;
+   ostringstream out;
+};
+
+static void usage() {
+   cout << "Usage: s7dbgen [-n namespace] -o header source..." << endl << endl
+         << "  -n   namespace of the generated structs, default s7db" << endl
+         << "  -o   header to write" << endl
+         << "  source   *.db and *.udt sources exported by TIA Portal, with standard block access" << endl;
+}
+
+int main(int argc, char *argv[]) {
+   string ns = "s7db";
+   const char* output = NULL;
+   int option;
+
+   while ((option = getopt(argc, argv, "n:o:")) != -1) {
+      switch (option) {
+      case 'n':
+         ns = optarg;
+         break;
+      case 'o':
+         output = optarg;
+         break;
+      default:
+         usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (!output || optind >= argc) {
+      usage();
+      return EXIT_FAILURE;
+   }
+
+   vector<Block> blocks;
+   try {
+      for (int i = optind; i < argc; ++i) {
+         ifstream in(argv[i]);
+         if (!in) {
+            throw SourceError { string(argv[i]) + ": unable to open" };
+         }
+         stringstream source;
+         source << in.rdbuf();
+         string text = source.str();
+         Lexer lexer(text, argv[i]);
+         Parser(lexer, argv[i]).parse(blocks);
+      }
+
+      string guard;
+      for (const char* p = strrchr(output, '/') ? strrchr(output, '/') + 1 : output; *p; ++p) {
+         guard += isalnum((unsigned char) *p) ? toupper((unsigned char) *p) : '_';
+      }
+      string header = Generator(blocks).generate(ns, "S7DBGEN_" + guard + "_");
+
+      ofstream out(output);
+      out << header;
+      if (!out) {
+         throw SourceError { string(output) + ": unable to write" };
+      }
+   } catch (const SourceError& e) {
+      cerr << "s7dbgen: " << e.message << endl;
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}